@@ -0,0 +1,476 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Host benchmark suite for elog_output and the asynchronous output ring buffer.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * Cases:
+ *   sync null    elog_output with asynchronous output disabled, the sink drops the log
+ *   sync fd      elog_output with asynchronous output disabled, the sink renders the line and writes it to /dev/null
+ *   async N thr  N producers log into the ring buffer while a drain thread empties it with elog_async_output_batch
+ *   drain        elog_async_get_line_log, elog_async_peek_line_log and elog_async_peek_line_logs on a full ring,
+ *                and elog_render of every record with the default format
+ *   fill P%      elog_output into a ring buffer kept P% full without a drain thread, 100% only drops
+ *
+ * Every elog_output call is timed on its own, the percentiles include the clock overhead printed first.
+ * The fill cases drain between the calls, so their ns/call is the sum of the call times instead of the wall time.
+ *
+ * Build and run: make -C bench run
+ *
+ * Usage: elog_bench [max_threads] [logs_per_thread]
+ */
+
+#include <elog.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_LOGS_PER_THREAD 200000
+/* percentiles in per mille */
+#define PERCENTILE_NUM 4
+static const unsigned percentiles[PERCENTILE_NUM] = {500, 900, 990, 999};
+/* ring buffer fill levels in percent */
+static const long fill_levels[] = {0, 50, 90, 100};
+
+static pthread_mutex_t   output_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_barrier_t start_barrier;
+static long              logs_per_thread = DEFAULT_LOGS_PER_THREAD;
+/* sink file of the sync fd case, -1: null sink */
+static int               sink_fd         = -1;
+static atomic_bool       drain_running;
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+
+void elog_port_deinit (void)
+{
+}
+
+void elog_port_output (const char *log, size_t size)
+{
+    char line[ELOG_LINE_BUF_SIZE];
+
+    if (sink_fd < 0)
+    {
+        return;
+    }
+    if (write(sink_fd, line, elog_render(log, size, line, sizeof(line))) < 0)
+    {
+        perror("write");
+    }
+}
+
+bool elog_port_output_lock (void)
+{
+    return pthread_mutex_lock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+bool elog_port_output_lock_isr (void)
+{
+    return pthread_mutex_trylock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock_isr (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+elog_timestamp_t elog_port_get_time (void)
+{
+    struct timespec  now;
+    elog_timestamp_t timestamp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms    = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+void elog_port_output_wait (void)
+{
+    sched_yield();
+}
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * log once and time it
+ *
+ * @param id producer id
+ * @param i log index
+ *
+ * @return call time in ns
+ */
+static uint32_t timed_log (long id, long i)
+{
+    uint64_t start = now_ns();
+    elog_i("bench", "thread %ld log %ld value %08lx %s %.3f", id, i, i * 2654435761UL, "payload", i / 7.0);
+    return (uint32_t)(now_ns() - start);
+}
+
+static int compare_time (const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void print_head (void)
+{
+    printf("%-14s %12s %9s", "case", "calls/s", "ns/call");
+    for (size_t i = 0; i < PERCENTILE_NUM; i++)
+    {
+        printf("   p%-5.1f", percentiles[i] / 10.0);
+    }
+    printf("%9s %9s\n", "max", "drops");
+}
+
+/**
+ * print the throughput and the latency percentiles of a case
+ *
+ * @param name case name
+ * @param times call times in ns, they get sorted
+ * @param count number of calls
+ * @param elapsed wall time of all calls in ns
+ * @param drops logs dropped by the case
+ */
+static void print_case (const char *name, uint32_t *times, size_t count, uint64_t elapsed, uint32_t drops)
+{
+    qsort(times, count, sizeof(uint32_t), compare_time);
+    printf("%-14s %12.0f %9.1f", name, count * 1e9 / elapsed, (double)elapsed / count);
+    for (size_t i = 0; i < PERCENTILE_NUM; i++)
+    {
+        printf(" %8lu", (unsigned long)times[count * percentiles[i] / 1000]);
+    }
+    printf(" %9lu %9lu\n", (unsigned long)times[count - 1], (unsigned long)drops);
+}
+
+static void *drain_thread (void *arg)
+{
+    (void)arg;
+    while (atomic_load(&drain_running))
+    {
+        if (elog_async_output_batch(SIZE_MAX) == 0)
+        {
+            sched_yield();
+        }
+    }
+    elog_async_output_batch(SIZE_MAX);
+    return NULL;
+}
+
+typedef struct
+{
+    long      id;
+    uint32_t *times;
+} producer_t;
+
+static void *producer_thread (void *arg)
+{
+    producer_t *producer = arg;
+
+    pthread_barrier_wait(&start_barrier);
+    for (long i = 0; i < logs_per_thread; i++)
+    {
+        producer->times[i] = timed_log(producer->id, i);
+    }
+    return NULL;
+}
+
+/**
+ * run n producers at once, the drain thread runs when asynchronous output is enabled
+ *
+ * @param name case name
+ * @param n number of producers
+ * @param async asynchronous output enabled
+ * @param times call times of all producers, n * logs_per_thread
+ */
+static void run_producers (const char *name, long n, bool async, uint32_t *times)
+{
+    pthread_t   drain;
+    pthread_t  *threads   = calloc(n, sizeof(pthread_t));
+    producer_t *producers = calloc(n, sizeof(producer_t));
+    uint32_t    drops     = elog_get_drop_count();
+
+    elog_async_enabled(async);
+    if (async)
+    {
+        atomic_store(&drain_running, true);
+        pthread_create(&drain, NULL, drain_thread, NULL);
+    }
+
+    pthread_barrier_init(&start_barrier, NULL, n + 1);
+    for (long i = 0; i < n; i++)
+    {
+        producers[i].id    = i;
+        producers[i].times = times + i * logs_per_thread;
+        pthread_create(&threads[i], NULL, producer_thread, &producers[i]);
+    }
+    pthread_barrier_wait(&start_barrier);
+    uint64_t start = now_ns();
+    for (long i = 0; i < n; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = now_ns() - start;
+    pthread_barrier_destroy(&start_barrier);
+
+    if (async)
+    {
+        atomic_store(&drain_running, false);
+        pthread_join(drain, NULL);
+    }
+    print_case(name, times, n * logs_per_thread, elapsed, elog_get_drop_count() - drops);
+
+    free(producers);
+    free(threads);
+}
+
+/**
+ * log until the ring buffer drops, asynchronous output must be enabled without the drain thread
+ *
+ * @return number of logs in the ring buffer
+ */
+static long fill_ring (void)
+{
+    uint32_t drops = elog_get_drop_count();
+    long     count = 0;
+
+    while (elog_get_drop_count() == drops)
+    {
+        elog_i("bench", "thread %ld log %ld value %08lx %s %.3f", 0L, count, count * 2654435761UL, "payload",
+               count / 7.0);
+        count++;
+    }
+    return count - 1;
+}
+
+/**
+ * time the drain of a full ring buffer with every consumer interface
+ *
+ * @return number of logs a full ring buffer holds
+ */
+static long bench_drain (void)
+{
+    static char log[ELOG_LINE_BUF_SIZE];
+    const char *record;
+    size_t      size;
+    elog_span_t spans[16];
+    long        full = 0;
+
+    printf("\n%-14s %12s %9s %9s\n", "drain", "records/s", "ns/rec", "MB/s");
+    for (int mode = 0; mode < 4; mode++)
+    {
+        static const char *names[] = {"get", "peek/release", "batch", "render"};
+        uint64_t           elapsed = 0, bytes = 0;
+        long               records = 0;
+
+        for (int round = 0; round < 20; round++)
+        {
+            full = fill_ring();
+
+            uint64_t start = now_ns();
+            if (mode == 0)
+            {
+                while (elog_async_get_line_log(log, sizeof(log)) == ELOG_NO_ERR)
+                {
+                    elog_header_t header;
+                    memcpy(&header, log, sizeof(elog_header_t));
+                    bytes += sizeof(elog_header_t) + header.message_length;
+                    records++;
+                }
+            }
+            else if (mode == 1)
+            {
+                while (elog_async_peek_line_log(&record, &size) == ELOG_NO_ERR)
+                {
+                    bytes += size;
+                    records++;
+                    elog_async_release_line_log();
+                }
+            }
+            else if (mode == 3)
+            {
+                while (elog_async_peek_line_log(&record, &size) == ELOG_NO_ERR)
+                {
+                    bytes += elog_render(record, size, log, sizeof(log));
+                    records++;
+                    elog_async_release_line_log();
+                }
+            }
+            else
+            {
+                size_t count;
+                while ((count = elog_async_peek_line_logs(spans, 16)) != 0)
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        bytes += spans[i].size;
+                    }
+                    records += count;
+                    elog_async_release_line_logs(count);
+                }
+            }
+            elapsed += now_ns() - start;
+        }
+        printf("%-14s %12.0f %9.1f %9.1f\n", names[mode], records * 1e9 / elapsed, (double)elapsed / records,
+               bytes * 1e3 / elapsed);
+    }
+
+    return full;
+}
+
+/**
+ * time logs into a ring buffer kept at a fill level, one record is drained after every log that got in
+ *
+ * @param full number of logs a full ring buffer holds
+ * @param percent fill level
+ * @param times call times, logs_per_thread
+ */
+static void bench_fill (long full, long percent, uint32_t *times)
+{
+    char     name[32];
+    uint32_t drops   = elog_get_drop_count();
+    uint64_t elapsed = 0;
+
+    if (percent >= 100)
+    {
+        fill_ring();
+    }
+    else
+    {
+        for (long i = 0; i < full * percent / 100; i++)
+        {
+            elog_i("bench", "thread %ld log %ld value %08lx %s %.3f", 0L, i, i * 2654435761UL, "payload", i / 7.0);
+        }
+    }
+
+    for (long i = 0; i < logs_per_thread; i++)
+    {
+        uint32_t before = elog_get_drop_count();
+        times[i]        = timed_log(0, i);
+        elapsed += times[i];
+        if (elog_get_drop_count() == before)
+        {
+            const char *record;
+            size_t      size;
+            if (elog_async_peek_line_log(&record, &size) == ELOG_NO_ERR)
+            {
+                elog_async_release_line_log();
+            }
+        }
+    }
+
+    snprintf(name, sizeof(name), "fill %ld%%", percent);
+    print_case(name, times, logs_per_thread, elapsed, elog_get_drop_count() - drops);
+    elog_async_output_batch(SIZE_MAX);
+}
+
+int main (int argc, char *argv[])
+{
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (argc > 1)
+    {
+        max_threads = strtol(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        logs_per_thread = strtol(argv[2], NULL, 0);
+    }
+    if (max_threads < 1 || logs_per_thread < 1)
+    {
+        fprintf(stderr, "usage: %s [max_threads] [logs_per_thread]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t *times = calloc(max_threads * logs_per_thread, sizeof(uint32_t));
+    if (times == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+    elog_async_output_batch(SIZE_MAX);
+
+    uint64_t start = now_ns();
+    for (long i = 0; i < logs_per_thread; i++)
+    {
+        now_ns();
+    }
+    printf("clock overhead %.1f ns\n\n", (double)(now_ns() - start) / logs_per_thread);
+
+    print_head();
+    run_producers("sync null", 1, false, times);
+    sink_fd = open("/dev/null", O_WRONLY);
+    run_producers("sync fd", 1, false, times);
+    close(sink_fd);
+    sink_fd = -1;
+    for (long n = 1; n <= max_threads; n++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "async %ld thr", n);
+        run_producers(name, n, true, times);
+    }
+
+    elog_async_enabled(true);
+    long full = bench_drain();
+
+    printf("\nring holds %ld logs\n", full);
+    print_head();
+    for (size_t i = 0; i < sizeof(fill_levels) / sizeof(fill_levels[0]); i++)
+    {
+        bench_fill(full, fill_levels[i], times);
+    }
+
+    free(times);
+    elog_stop();
+    elog_deinit();
+    return 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: File sink: group commit against a write and fdatasync per log, rotation and reopen.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * The logs are drained with elog_async_output_batch into the file sink (lib/plugins/file) in a scratch
+ * directory, then read back and compared line by line with the messages. The same lines are written once
+ * more with a write and an fdatasync per log, as a sink without group commit does. A last run with small
+ * segments checks the rotation: the segments hold every log once and in order, none is larger than its
+ * limit, and a reopened segment is continued.
+ *
+ * Build and run: make -C bench run-file
+ *
+ * Usage: elog_bench_file [logs [dir]]
+ */
+
+#include <elog.h>
+#include <elog_file.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_LOGS    200000
+/* logs between two drains, they must fit in the ring buffer */
+#define DRAIN_LOGS      200
+/* logs of the fdatasync per log case, it is slow */
+#define SYNC_LOGS       2000
+/* segments of the rotation case */
+#define ROTATE_SIZE     (256 * 1024)
+#define ROTATE_NUM      64
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    elog_file_write(log, size);
+}
+void elog_port_output_batch (const elog_span_t *logs, size_t count)
+{
+    elog_file_write_batch(logs, count);
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    static uint64_t  ms = 1792238400000; /* 2026-10-17 */
+    elog_timestamp_t timestamp;
+
+    ms += 3;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* message of log i */
+static int make_message (long i, char *buf, size_t size)
+{
+    return snprintf(buf, size, "rx frame %ld len %ld crc ok", i, 64 + i % 1400);
+}
+
+/* log messages from first to end and drain them every DRAIN_LOGS logs */
+static void log_messages (long first, long end)
+{
+    for (long i = first; i < end; i += DRAIN_LOGS)
+    {
+        for (long j = i; j < i + DRAIN_LOGS && j < end; j++)
+        {
+            char message[64];
+
+            make_message(j, message, sizeof(message));
+            elog_i("file", "%s", message);
+        }
+        elog_async_output_batch(SIZE_MAX);
+    }
+}
+
+static char *read_file (const char *name, size_t *size)
+{
+    FILE *file = fopen(name, "rb");
+    char *data;
+    long  len;
+
+    if (file == NULL)
+    {
+        *size = 0;
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    len  = ftell(file);
+    data = malloc((size_t)len + 1);
+    fseek(file, 0, SEEK_SET);
+    *size = fread(data, 1, (size_t)len, file);
+    fclose(file);
+
+    return data;
+}
+
+/**
+ * compare the lines of a file with the messages from *next on
+ *
+ * @return false when a line isn't the next message
+ */
+static bool check_file (const char *name, long *next)
+{
+    size_t      size;
+    char       *data = read_file(name, &size);
+    const char *line = data;
+    const char *end  = data + size;
+    bool        ok   = true;
+
+    while (data != NULL && line < end)
+    {
+        char        message[64];
+        int         len      = make_message(*next, message, sizeof(message));
+        const char *line_end = memchr(line, '\n', (size_t)(end - line));
+
+        if (line_end == NULL || line_end - line < len || memcmp(line_end - len, message, (size_t)len) != 0)
+        {
+            printf("FAIL %s log %ld: \"%.*s\"\n", name, *next, line_end ? (int)(line_end - line) : 0, line);
+            ok = false;
+            break;
+        }
+        line = line_end + 1;
+        (*next)++;
+    }
+    free(data);
+
+    return ok;
+}
+
+/* write the lines of a file again with a write and an fdatasync per line */
+static double bench_sync_per_log (const char *from, const char *to, long logs)
+{
+    size_t      size;
+    char       *data = read_file(from, &size);
+    const char *line = data;
+    int         fd   = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    uint64_t    start;
+
+    start = now_ns();
+    for (long i = 0; i < logs && line < data + size; i++)
+    {
+        const char *line_end = memchr(line, '\n', (size_t)(data + size - line));
+        size_t      len      = (size_t)(line_end - line) + 1;
+
+        if (write(fd, line, len) != (ssize_t)len)
+        {
+            break;
+        }
+        fdatasync(fd);
+        line += len;
+    }
+    double ns = (double)(now_ns() - start) / logs;
+    close(fd);
+    free(data);
+
+    return ns;
+}
+
+int main (int argc, char *argv[])
+{
+    long        logs = DEFAULT_LOGS;
+    const char *dir  = "elog_bench_file.d";
+    char        name[256], segment[300];
+    bool        ok = true;
+
+    if (argc > 1)
+    {
+        logs = strtol(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        dir = argv[2];
+    }
+    if (logs < 1)
+    {
+        fprintf(stderr, "usage: %s [logs [dir]]\n", argv[0]);
+        return 1;
+    }
+    mkdir(dir, 0755);
+    elog_set_fmt(ELOG_LVL_INFO, ELOG_FMT_LVL | ELOG_FMT_TAG);
+
+    /* group commit, one segment */
+    snprintf(name, sizeof(name), "%s/group.log", dir);
+    unlink(name);
+    elog_file_cfg_t cfg = {
+        .name = name, .max_size = SIZE_MAX, .max_rotate = 0, .rotate_period = 0, .sync_period = ELOG_FILE_SYNC_PERIOD};
+    elog_file_config(&cfg);
+    elog_init();
+    elog_start();
+    /* the logs of elog_start are dropped, the sink isn't open yet */
+    elog_async_output_batch(SIZE_MAX);
+    elog_file_init();
+
+    uint64_t start = now_ns();
+    log_messages(0, logs);
+    elog_file_flush();
+    double group_ns = (double)(now_ns() - start) / logs;
+    elog_file_deinit();
+
+    long next = 0;
+    ok = check_file(name, &next) && next == logs && ok;
+    printf("group      %ld logs, %.0f ns/log\n", logs, group_ns);
+
+    snprintf(segment, sizeof(segment), "%s/sync.log", dir);
+    long   sync_logs = (logs < SYNC_LOGS) ? logs : SYNC_LOGS;
+    double sync_ns   = bench_sync_per_log(name, segment, sync_logs);
+    printf("sync       %ld logs, %.0f ns/log, %.0fx the group commit\n", sync_logs, sync_ns, sync_ns / group_ns);
+    unlink(segment);
+    unlink(name);
+
+    /* rotation, the segments are continued after a reopen in the middle */
+    snprintf(name, sizeof(name), "%s/rotate.log", dir);
+    for (int i = 0; i < ROTATE_NUM; i++)
+    {
+        snprintf(segment, sizeof(segment), "%s.%d", name, i);
+        unlink(segment);
+    }
+    unlink(name);
+    cfg.name       = name;
+    cfg.max_size   = ROTATE_SIZE;
+    cfg.max_rotate = ROTATE_NUM;
+    elog_file_config(&cfg);
+    elog_file_init();
+    log_messages(0, logs / 2);
+    elog_file_deinit();
+    elog_file_init();
+    log_messages(logs / 2, logs);
+    elog_file_deinit();
+
+    int segments = 0;
+    next = 0;
+    for (int i = ROTATE_NUM - 1; i >= -1; i--)
+    {
+        struct stat st;
+
+        if (i >= 0)
+        {
+            snprintf(segment, sizeof(segment), "%s.%d", name, i);
+        }
+        else
+        {
+            snprintf(segment, sizeof(segment), "%s", name);
+        }
+        if (stat(segment, &st) != 0)
+        {
+            continue;
+        }
+        /* a segment rotates at its first log past the limit */
+        if ((size_t)st.st_size > ROTATE_SIZE + ELOG_LINE_BUF_SIZE)
+        {
+            printf("FAIL %s is %ld bytes\n", segment, (long)st.st_size);
+            ok = false;
+        }
+        ok = check_file(segment, &next) && ok;
+        unlink(segment);
+        segments++;
+    }
+    ok = ok && next == logs;
+    printf("rotate     %ld logs in %d segments of %d KiB\n", next, segments, ROTATE_SIZE / 1024);
+    rmdir(dir);
+
+    printf("%s\n", ok ? "files match the logs" : "files differ");
+    return ok ? 0 : 1;
+}
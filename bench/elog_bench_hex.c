@@ -0,0 +1,210 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: elog_hexdump against a hexdump formatted by elog_d, output check and ns per dump.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * A packet is dumped with elog_hexdump and with the usual per-byte "%02X " loop feeding elog_d one line at
+ * a time. The producer and the drain (elog_async_get_line_log) are timed apart, the drained text of both
+ * must be the same. The bench Makefile builds it with ELOG_HEXDUMP_ENABLE.
+ *
+ * Build and run: make -C bench run-hex
+ *
+ * Usage: elog_bench_hex [dumps] [packet_size]
+ */
+
+#include <elog.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_DUMPS  200000
+#define DEFAULT_PACKET 256
+#define MAX_PACKET     4096
+/* the drained text of one dump */
+#define TEXT_SIZE      (MAX_PACKET / ELOG_HEXDUMP_WIDTH * ELOG_HEXDUMP_LINE_LEN + ELOG_HEXDUMP_LINE_LEN)
+
+/* the bench drains the ring buffer itself, the port only has to link */
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    (void)log;
+    (void)size;
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    elog_timestamp_t timestamp = {0, 0};
+    return timestamp;
+}
+
+static long    dumps  = DEFAULT_DUMPS;
+static size_t  packet = DEFAULT_PACKET;
+static uint8_t packet_buf[MAX_PACKET];
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* the hexdump as it is done without elog_hexdump, one elog_d per line */
+static void hexdump_printf (const uint8_t *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i += ELOG_HEXDUMP_WIDTH)
+    {
+        char   line[ELOG_HEXDUMP_LINE_LEN + 1];
+        size_t num = (size - i < ELOG_HEXDUMP_WIDTH) ? size - i : ELOG_HEXDUMP_WIDTH;
+        int    pos = snprintf(line, sizeof(line), "%08X  ", (unsigned)i);
+
+        for (size_t j = 0; j < ELOG_HEXDUMP_WIDTH; j++)
+        {
+            pos += (j < num) ? snprintf(line + pos, sizeof(line) - pos, "%02X ", buf[i + j])
+                             : snprintf(line + pos, sizeof(line) - pos, "   ");
+        }
+        pos += snprintf(line + pos, sizeof(line) - pos, " |");
+        for (size_t j = 0; j < num; j++)
+        {
+            pos += snprintf(line + pos, sizeof(line) - pos, "%c",
+                            (buf[i + j] >= 0x20 && buf[i + j] < 0x7F) ? buf[i + j] : '.');
+        }
+        snprintf(line + pos, sizeof(line) - pos, "|");
+        elog_d("H", "%s", line);
+    }
+}
+
+/* drain the ring buffer and join the messages */
+static size_t drain (char *text, size_t size)
+{
+    static char log[ELOG_LINE_BUF_SIZE];
+    size_t      len = 0;
+
+    while (elog_async_get_line_log(log, sizeof(log)) == ELOG_NO_ERR)
+    {
+        elog_header_t header;
+
+        memcpy(&header, log, sizeof(header));
+        if (text != NULL && len + header.message_length <= size)
+        {
+            memcpy(text + len, log + sizeof(header), header.message_length);
+            len += header.message_length;
+        }
+    }
+    return len;
+}
+
+static void bench (const char *name, bool hexdump)
+{
+    uint64_t produce_ns = 0, drain_ns = 0, start;
+
+    for (long i = 0; i < dumps; i++)
+    {
+        start = now_ns();
+        if (hexdump)
+        {
+            elog_hexdump("H", ELOG_LVL_DEBUG, packet_buf, packet);
+        }
+        else
+        {
+            hexdump_printf(packet_buf, packet);
+        }
+        produce_ns += now_ns() - start;
+        start = now_ns();
+        drain(NULL, 0);
+        drain_ns += now_ns() - start;
+    }
+    printf("%-10s %12.1f %12.1f %12.1f\n", name, (double)produce_ns / dumps, (double)drain_ns / dumps,
+           (double)(produce_ns + drain_ns) / dumps);
+}
+
+int main (int argc, char *argv[])
+{
+    static char expected[TEXT_SIZE], actual[TEXT_SIZE];
+    size_t      expected_len, actual_len;
+
+    if (argc > 1)
+    {
+        dumps = strtol(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        packet = strtoul(argv[2], NULL, 0);
+    }
+    if (dumps < 1 || packet < 1 || packet > MAX_PACKET)
+    {
+        fprintf(stderr, "usage: %s [dumps] [packet_size (1-%d)]\n", argv[0], MAX_PACKET);
+        return 1;
+    }
+    for (size_t i = 0; i < packet; i++)
+    {
+        packet_buf[i] = (uint8_t)(i * 37 + (i >> 8));
+    }
+
+    elog_init();
+    elog_start();
+    drain(NULL, 0);
+
+    hexdump_printf(packet_buf, packet);
+    expected_len = drain(expected, sizeof(expected));
+    elog_hexdump("H", ELOG_LVL_DEBUG, packet_buf, packet);
+    actual_len = drain(actual, sizeof(actual));
+    if (expected_len != actual_len || memcmp(expected, actual, actual_len) != 0)
+    {
+        printf("FAIL hexdump text differs:\n%.*s---\n%.*s", (int)expected_len, expected, (int)actual_len, actual);
+        return 1;
+    }
+
+    printf("%lu dumps of %zu bytes\n", (unsigned long)dumps, packet);
+    printf("%-10s %12s %12s %12s\n", "case", "producer ns", "drain ns", "total ns");
+    bench("elog_d", false);
+    bench("hexdump", true);
+    return 0;
+}
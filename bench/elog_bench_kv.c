@@ -0,0 +1,184 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: elog_kv against the same fields formatted by elog_d, output check and ns per log.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * A metrics log of a few fields is output with elog_kv and with elog_d and its format string. The producer
+ * and the drain (elog_async_get_line_log) are timed apart, the drained text of both must be the same.
+ * The drain is timed for the JSON rendering too. The bench Makefile builds it with ELOG_KV_ENABLE.
+ *
+ * Build and run: make -C bench run-kv
+ *
+ * Usage: elog_bench_kv [logs]
+ */
+
+#include <elog.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_LOGS 1000000
+
+/* the bench drains the ring buffer itself, the port only has to link */
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    (void)log;
+    (void)size;
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    elog_timestamp_t timestamp = {0, 0};
+    return timestamp;
+}
+
+static long logs = DEFAULT_LOGS;
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* the metrics of one log, they change with i so nothing is folded away */
+static void log_printf (long i)
+{
+    elog_d("K", "rx=%" PRIu32 " err=%" PRIu32 " rssi=%" PRId32 " bytes=%" PRIu64 " iface=%s", (uint32_t)i,
+           (uint32_t)(i & 7), (int32_t)(-40 - (i & 31)), (uint64_t)i * 1500, "eth0");
+}
+
+static void log_kv (long i)
+{
+    elog_kv("K", ELOG_LVL_DEBUG, ELOG_U32("rx", i), ELOG_U32("err", i & 7), ELOG_I32("rssi", -40 - (i & 31)),
+            ELOG_U64("bytes", (uint64_t)i * 1500), ELOG_STR("iface", "eth0"));
+}
+
+/* drain the ring buffer, the messages are kept when there is room for them */
+static size_t drain (char *text, size_t size)
+{
+    static char log[ELOG_LINE_BUF_SIZE];
+    size_t      len = 0;
+
+    while (elog_async_get_line_log(log, sizeof(log)) == ELOG_NO_ERR)
+    {
+        elog_header_t header;
+
+        memcpy(&header, log, sizeof(header));
+        if (text != NULL && len + header.message_length <= size)
+        {
+            memcpy(text + len, log + sizeof(header), header.message_length);
+            len += header.message_length;
+        }
+    }
+    return len;
+}
+
+static void bench (const char *name, void (*output)(long i))
+{
+    uint64_t produce_ns = 0, drain_ns = 0, start;
+
+    /* a batch of logs between two drains, they must fit in the ring buffer */
+    for (long i = 0; i < logs; i += 64)
+    {
+        start = now_ns();
+        for (long j = i; j < i + 64 && j < logs; j++)
+        {
+            output(j);
+        }
+        produce_ns += now_ns() - start;
+        start = now_ns();
+        drain(NULL, 0);
+        drain_ns += now_ns() - start;
+    }
+    printf("%-10s %12.1f %12.1f %12.1f\n", name, (double)produce_ns / logs, (double)drain_ns / logs,
+           (double)(produce_ns + drain_ns) / logs);
+}
+
+int main (int argc, char *argv[])
+{
+    char   expected[256], actual[256];
+    size_t expected_len, actual_len;
+
+    if (argc > 1)
+    {
+        logs = strtol(argv[1], NULL, 0);
+    }
+    if (logs < 1)
+    {
+        fprintf(stderr, "usage: %s [logs]\n", argv[0]);
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+    drain(NULL, 0);
+
+    log_printf(12345);
+    expected_len = drain(expected, sizeof(expected));
+    log_kv(12345);
+    actual_len = drain(actual, sizeof(actual));
+    if (expected_len != actual_len || memcmp(expected, actual, actual_len) != 0)
+    {
+        printf("FAIL kv text differs:\n%.*s%.*s", (int)expected_len, expected, (int)actual_len, actual);
+        return 1;
+    }
+
+    printf("%lu logs\n", (unsigned long)logs);
+    printf("%-10s %12s %12s %12s\n", "case", "producer ns", "drain ns", "total ns");
+    bench("elog_d", log_printf);
+    bench("kv text", log_kv);
+    elog_set_kv_json(true);
+    bench("kv json", log_kv);
+    return 0;
+}
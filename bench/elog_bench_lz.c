@@ -0,0 +1,353 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Compressed drain output: ratio, drain and codec speed, and stream resync after loss.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * The logs are drained with elog_async_output_batch into a memory stream of frames, which is decoded
+ * again in small chunks and compared line by line with the messages. Then the stream is damaged (flipped
+ * bytes and cut pieces) and decoded again: every decoded block must be an original block, the rest is lost.
+ * The bench Makefile builds it with ELOG_ASYNC_COMPRESS_ENABLE.
+ *
+ * Build and run: make -C bench run-lz
+ *
+ * Usage: elog_bench_lz [logs]
+ */
+
+#include <elog.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_LOGS    200000
+/* logs between two drains, they must fit in the ring buffer */
+#define DRAIN_LOGS      200
+/* block size of the frame decoder and the codec cases */
+#define BLOCK_SIZE      ELOG_ASYNC_COMPRESS_BLOCK_SIZE
+/* damage of the resync case: a flipped byte and a cut piece every so many stream bytes */
+#define FLIP_PERIOD     7919
+#define CUT_PERIOD      20011
+#define CUT_SIZE        97
+/* stream bytes fed to the decoder at once */
+#define DECODE_CHUNK    61
+
+typedef struct
+{
+    char  *data;
+    size_t size;
+    size_t capacity;
+} bench_buf_t;
+
+/* frames of elog_port_output_frame */
+static bench_buf_t stream;
+/* decoded text and the blocks it was decoded from */
+static bench_buf_t text;
+static size_t     *block_ends;
+static size_t      block_num;
+
+static void buf_append (bench_buf_t *buf, const char *data, size_t size)
+{
+    if (buf->size + size > buf->capacity)
+    {
+        buf->capacity = (buf->size + size) * 2;
+        buf->data     = realloc(buf->data, buf->capacity);
+        if (buf->data == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+}
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    (void)log;
+    (void)size;
+}
+void elog_port_output_frame (const char *frame, size_t size)
+{
+    buf_append(&stream, frame, size);
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    static uint64_t  ms = 1792238400000; /* 2026-10-17 */
+    elog_timestamp_t timestamp;
+
+    ms += 3;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* message of log i, a few typical templates with changing values */
+static int make_message (long i, char *buf, size_t size)
+{
+    switch (i % 4)
+    {
+    case 0:
+        return snprintf(buf, size, "rx frame %ld len %ld crc ok", i, 64 + i % 1400);
+    case 1:
+        return snprintf(buf, size, "sensor %ld temp %ld.%ld C", i % 8, 20 + i % 15, i % 10);
+    case 2:
+        return snprintf(buf, size, "task %s stack %ld of 4096 used", (i & 8) ? "net" : "ctrl", 1024 + i % 512);
+    default:
+        return snprintf(buf, size, "retry %ld to 10.0.%ld.%ld:443", i % 3, i % 4, i % 250);
+    }
+}
+
+static void log_message (long i)
+{
+    char message[64];
+
+    make_message(i, message, sizeof(message));
+    elog_i("lz", "%s", message);
+}
+
+/**
+ * feed a stream to the frame decoder DECODE_CHUNK bytes at a time
+ *
+ * @param data stream
+ * @param size stream size
+ * @param check whether every block must be an original block, the original blocks are recorded otherwise
+ *
+ * @return decoded blocks, -1 when a block isn't an original one
+ */
+static long decode_stream (const char *data, size_t size, bool check)
+{
+    static char pending[ELOG_LZ_FRAME_SIZE(BLOCK_SIZE) + DECODE_CHUNK];
+    char        block[BLOCK_SIZE];
+    size_t      pending_size = 0;
+    size_t      next         = 0;
+    long        blocks       = 0;
+
+    for (size_t pos = 0; pos < size; pos += DECODE_CHUNK)
+    {
+        size_t len = (size - pos < DECODE_CHUNK) ? size - pos : DECODE_CHUNK;
+        memcpy(pending + pending_size, data + pos, len);
+        pending_size += len;
+
+        for (;;)
+        {
+            size_t consumed;
+            size_t block_size = elog_lz_frame_decode(pending, pending_size, &consumed, block, sizeof(block));
+
+            memmove(pending, pending + consumed, pending_size - consumed);
+            pending_size -= consumed;
+            if (block_size == 0)
+            {
+                break;
+            }
+            blocks++;
+            if (!check)
+            {
+                buf_append(&text, block, block_size);
+                block_ends = realloc(block_ends, (block_num + 1) * sizeof(size_t));
+                block_ends[block_num++] = text.size;
+                continue;
+            }
+            /* the blocks in between were lost */
+            for (; next < block_num; next++)
+            {
+                size_t start = next ? block_ends[next - 1] : 0;
+                if (block_ends[next] - start == block_size && memcmp(text.data + start, block, block_size) == 0)
+                {
+                    break;
+                }
+            }
+            if (next++ == block_num)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return blocks;
+}
+
+/* compare the decoded lines with the messages */
+static bool check_lines (long logs)
+{
+    const char *line = text.data;
+    const char *end  = text.data + text.size;
+
+    for (long i = 0; i < logs; i++)
+    {
+        char        message[64];
+        int         len      = make_message(i, message, sizeof(message));
+        const char *line_end = memchr(line, '\n', (size_t)(end - line));
+
+        if (line_end == NULL || line_end - line < len || memcmp(line_end - len, message, (size_t)len) != 0)
+        {
+            printf("FAIL line %ld: \"%.*s\"\n", i, line_end ? (int)(line_end - line) : 0, line);
+            return false;
+        }
+        line = line_end + 1;
+    }
+    if (line != end)
+    {
+        printf("FAIL %zu bytes after the last line\n", (size_t)(end - line));
+        return false;
+    }
+
+    return true;
+}
+
+/* compress and decompress the decoded text block by block */
+static void bench_codec (void)
+{
+    static char compressed[BLOCK_SIZE];
+    static char block[BLOCK_SIZE];
+    size_t      compressed_size = 0;
+    uint64_t    compress_ns     = 0;
+    uint64_t    decompress_ns   = 0;
+
+    for (size_t i = 0; i < block_num; i++)
+    {
+        size_t start = i ? block_ends[i - 1] : 0;
+        size_t size  = block_ends[i] - start;
+
+        uint64_t t = now_ns();
+        size_t   n = elog_lz_compress(text.data + start, size, compressed, sizeof(compressed));
+        compress_ns += now_ns() - t;
+        if (n == 0)
+        {
+            continue;
+        }
+        compressed_size += n;
+
+        t = now_ns();
+        size_t m = elog_lz_decompress(compressed, n, block, sizeof(block));
+        decompress_ns += now_ns() - t;
+        if (m != size || memcmp(block, text.data + start, size) != 0)
+        {
+            printf("FAIL block %zu round trip\n", i);
+        }
+    }
+
+    printf("codec      %zu blocks, ratio %.2f, compress %.0f MB/s, decompress %.0f MB/s\n", block_num,
+           (double)text.size / compressed_size, text.size * 1e3 / compress_ns, text.size * 1e3 / decompress_ns);
+}
+
+int main (int argc, char *argv[])
+{
+    long logs = DEFAULT_LOGS;
+
+    if (argc > 1)
+    {
+        logs = strtol(argv[1], NULL, 0);
+    }
+    if (logs < 1)
+    {
+        fprintf(stderr, "usage: %s [logs]\n", argv[0]);
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+    elog_async_output_batch(SIZE_MAX);
+    stream.size = 0;
+
+    uint64_t drain_ns = 0;
+    for (long i = 0; i < logs; i += DRAIN_LOGS)
+    {
+        for (long j = i; j < i + DRAIN_LOGS && j < logs; j++)
+        {
+            log_message(j);
+        }
+        uint64_t start = now_ns();
+        elog_async_output_batch(SIZE_MAX);
+        drain_ns += now_ns() - start;
+    }
+
+    decode_stream(stream.data, stream.size, false);
+    bool ok = check_lines(logs);
+    printf("drain      %ld logs, %zu text bytes, %zu stream bytes, ratio %.2f, %.1f ns/log\n", logs, text.size,
+           stream.size, (double)text.size / stream.size, (double)drain_ns / logs);
+
+    bench_codec();
+
+    /* damage a copy of the stream */
+    char  *damaged = malloc(stream.size);
+    size_t size    = 0;
+    for (size_t pos = 0; pos < stream.size; pos++)
+    {
+        if (pos % CUT_PERIOD == CUT_PERIOD - 1)
+        {
+            pos += CUT_SIZE;
+            continue;
+        }
+        damaged[size++] = (char)(stream.data[pos] ^ ((pos % FLIP_PERIOD == FLIP_PERIOD - 1) ? 0x10 : 0));
+    }
+    long blocks = decode_stream(damaged, size, true);
+    if (blocks < 0)
+    {
+        printf("FAIL a damaged frame was decoded\n");
+        ok = false;
+    }
+    else
+    {
+        printf("resync     %ld of %zu blocks decoded from the damaged stream\n", blocks, block_num);
+    }
+    free(damaged);
+
+    printf("%s\n", ok ? "stream matches the logs" : "stream differs");
+    return ok ? 0 : 1;
+}
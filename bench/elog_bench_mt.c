@@ -0,0 +1,174 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Multi-threaded elog_output throughput benchmark for Linux.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * Every thread logs into a null sink with asynchronous output disabled, so the numbers show how
+ * elog_output itself scales with the number of logging threads.
+ *
+ * Build and run: make -C bench run-mt
+ *
+ * Usage: elog_bench_mt [max_threads] [logs_per_thread]
+ */
+
+#include <elog.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_LOGS_PER_THREAD 200000
+
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_barrier_t start_barrier;
+static long logs_per_thread = DEFAULT_LOGS_PER_THREAD;
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+
+void elog_port_deinit (void)
+{
+}
+
+void elog_port_output (const char *log, size_t size)
+{
+    /* null sink */
+    (void)log;
+    (void)size;
+}
+
+bool elog_port_output_lock (void)
+{
+    return pthread_mutex_lock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+bool elog_port_output_lock_isr (void)
+{
+    return pthread_mutex_trylock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock_isr (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+elog_timestamp_t elog_port_get_time (void)
+{
+    struct timespec  now;
+    elog_timestamp_t timestamp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms    = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+static double now_sec (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void *bench_thread (void *arg)
+{
+    long id = (long)arg;
+
+    pthread_barrier_wait(&start_barrier);
+    for (long i = 0; i < logs_per_thread; i++)
+    {
+        elog_i("bench", "thread %ld log %ld value %08lx %s %.3f", id, i, i * 2654435761UL, "payload", i / 7.0);
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (argc > 1)
+    {
+        max_threads = strtol(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        logs_per_thread = strtol(argv[2], NULL, 0);
+    }
+    if (max_threads < 1 || logs_per_thread < 1)
+    {
+        fprintf(stderr, "usage: %s [max_threads] [logs_per_thread]\n", argv[0]);
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+    elog_async_enabled(false);
+
+    pthread_t *threads     = calloc(max_threads, sizeof(pthread_t));
+    double     single_rate = 0;
+
+    printf("%8s %14s %10s %8s\n", "threads", "logs/s", "ns/log", "speedup");
+    for (long n = 1; n <= max_threads; n++)
+    {
+        pthread_barrier_init(&start_barrier, NULL, n + 1);
+        for (long i = 0; i < n; i++)
+        {
+            pthread_create(&threads[i], NULL, bench_thread, (void *)i);
+        }
+
+        pthread_barrier_wait(&start_barrier);
+        double start = now_sec();
+        for (long i = 0; i < n; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        double elapsed = now_sec() - start;
+        pthread_barrier_destroy(&start_barrier);
+
+        double rate = n * logs_per_thread / elapsed;
+        if (n == 1)
+        {
+            single_rate = rate;
+        }
+        printf("%8ld %14.0f %10.1f %8.2f\n", n, rate, 1e9 / rate, rate / single_rate);
+    }
+
+    free(threads);
+    elog_stop();
+    elog_deinit();
+    return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Sequence order check of the lane merge under load for Linux.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * One producer logs into the ISR, high severity and output lanes while a drain thread empties them, every
+ * other round with elog_async_peek_line_logs and with elog_async_peek_line_log. Then a task thread and an
+ * interrupt thread log at the same time, the interrupt logs take the ISR lane without the output lock,
+ * so their sequence numbers are taken concurrently with the task ones. The lanes are small, so
+ * they overflow and the drain keeps up with the producer. A drained record must have a higher sequence
+ * number than every one drained before it, gap markers included.
+ * The exit status is 1 when one did.
+ *
+ * Build and run: make -C bench run-order
+ *
+ * Usage: elog_bench_order [logs]
+ */
+
+#include <elog.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_LOGS 2000000
+
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool     producing   = true;
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+
+void elog_port_deinit (void)
+{
+}
+
+void elog_port_output (const char *log, size_t size)
+{
+    /* null sink */
+    (void)log;
+    (void)size;
+}
+
+bool elog_port_output_lock (void)
+{
+    return pthread_mutex_lock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+bool elog_port_output_lock_isr (void)
+{
+    return pthread_mutex_trylock(&output_lock) == 0;
+}
+
+bool elog_port_output_unlock_isr (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+elog_timestamp_t elog_port_get_time (void)
+{
+    struct timespec  now;
+    elog_timestamp_t timestamp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms    = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+/* drained records, records out of order and the sequence number of the last record */
+static uint64_t drained;
+static uint64_t misordered;
+static uint32_t last_seq;
+
+static void check_record (const char *record)
+{
+    elog_header_t header;
+
+    memcpy(&header, record, sizeof(header));
+    if (drained != 0 && (int32_t)(header.seq_num - last_seq) <= 0)
+    {
+        if (misordered < 10)
+        {
+            printf("seq %u after %u\n", header.seq_num, last_seq);
+        }
+        misordered++;
+    }
+    else
+    {
+        last_seq = header.seq_num;
+    }
+    drained++;
+}
+
+/* empty the lanes, returns false when they were empty */
+static bool drain_round (bool batch)
+{
+    elog_span_t logs[16];
+    const char *record;
+    size_t      size;
+    size_t      count = 0;
+
+    if (batch)
+    {
+        count = elog_async_peek_line_logs(logs, 16);
+        for (size_t i = 0; i < count; i++)
+        {
+            check_record(logs[i].data);
+        }
+        elog_async_release_line_logs(count);
+    }
+    else if (elog_async_peek_line_log(&record, &size) == ELOG_NO_ERR)
+    {
+        check_record(record);
+        elog_async_release_line_log();
+        count = 1;
+    }
+    return count != 0;
+}
+
+/* interrupt logs of the concurrent round, as from an interrupt on another core */
+static void *isr_thread (void *arg)
+{
+    long logs = *(const long *)arg;
+
+    for (long i = 0; i < logs; i++)
+    {
+        elog_i_isr("order", "isr %ld", i);
+    }
+    return NULL;
+}
+
+static void *drain_thread (void *arg)
+{
+    bool batch = false;
+
+    (void)arg;
+    while (atomic_load(&producing))
+    {
+        drain_round(batch = !batch);
+    }
+    while (drain_round(true))
+    {
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+    long      logs = DEFAULT_LOGS;
+    pthread_t drain;
+    pthread_t isr;
+
+    if (argc > 1)
+    {
+        logs = strtol(argv[1], NULL, 0);
+    }
+    if (logs < 1)
+    {
+        fprintf(stderr, "usage: %s [logs]\n", argv[0]);
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+    while (drain_round(true))
+    {
+    }
+
+    pthread_create(&drain, NULL, drain_thread, NULL);
+    for (long i = 0; i < logs; i++)
+    {
+        switch (i % 8)
+        {
+            case 0:
+            case 3:
+                elog_i_isr("order", "isr %ld", i);
+                break;
+            case 5:
+                elog_e("order", "error %ld", i);
+                break;
+            default:
+                elog_i("order", "info %ld", i);
+                break;
+        }
+    }
+    pthread_create(&isr, NULL, isr_thread, &logs);
+    for (long i = 0; i < logs; i++)
+    {
+        if (i % 4 == 3)
+        {
+            elog_e("order", "error %ld", i);
+        }
+        else
+        {
+            elog_i("order", "info %ld", i);
+        }
+    }
+    pthread_join(isr, NULL);
+    atomic_store(&producing, false);
+    pthread_join(drain, NULL);
+
+    printf("%llu logs drained, %u dropped, %llu out of order\n", (unsigned long long)drained, elog_get_drop_count(),
+           (unsigned long long)misordered);
+
+    elog_stop();
+    elog_deinit();
+    return misordered != 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Built-in formatter against the libc vsnprintf, output check and ns per call.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * Every case is formatted by both, a different text is reported and counts as a failure.
+ * The bench Makefile builds it with ELOG_PRINTF_ENABLE and ELOG_PRINTF_FLOAT_ENABLE.
+ *
+ * Build and run: make -C bench run-printf
+ *
+ * Usage: elog_bench_printf [calls_per_case]
+ */
+
+#include <elog.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CALLS 1000000
+
+extern int elog_vsnprintf (char *buf, size_t size, const char *format, va_list args);
+
+typedef int (*vformat_t)(char *buf, size_t size, const char *format, va_list args);
+
+/* the bench doesn't output logs, the port only has to link */
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    (void)log;
+    (void)size;
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    elog_timestamp_t timestamp = {0, 0};
+    return timestamp;
+}
+
+static long calls    = DEFAULT_CALLS;
+static int  failures = 0;
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static int call_format (vformat_t vformat, char *buf, size_t size, const char *format, ...)
+{
+    va_list args;
+    int     result;
+
+    va_start(args, format);
+    result = vformat(buf, size, format, args);
+    va_end(args);
+    return result;
+}
+
+/* check the output of one case and time it with both formatters, the args are evaluated once per call */
+#define BENCH_CASE(name, format, ...)                                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        char     expected[256], actual[256];                                                                           \
+        int      expected_len = call_format(vsnprintf, expected, sizeof(expected), format, __VA_ARGS__);              \
+        int      actual_len   = call_format(elog_vsnprintf, actual, sizeof(actual), format, __VA_ARGS__);             \
+        uint64_t libc_ns, elog_ns;                                                                                     \
+                                                                                                                       \
+        if (expected_len != actual_len || strcmp(expected, actual) != 0)                                               \
+        {                                                                                                              \
+            printf("FAIL %-12s \"%s\": libc \"%s\" (%d), elog \"%s\" (%d)\n", name, format, expected, expected_len,   \
+                   actual, actual_len);                                                                                \
+            failures++;                                                                                                \
+        }                                                                                                              \
+        libc_ns = now_ns();                                                                                            \
+        for (long i = 0; i < calls; i++)                                                                               \
+        {                                                                                                              \
+            call_format(vsnprintf, expected, sizeof(expected), format, __VA_ARGS__);                                  \
+        }                                                                                                              \
+        libc_ns = now_ns() - libc_ns;                                                                                  \
+        elog_ns = now_ns();                                                                                            \
+        for (long i = 0; i < calls; i++)                                                                               \
+        {                                                                                                              \
+            call_format(elog_vsnprintf, actual, sizeof(actual), format, __VA_ARGS__);                                 \
+        }                                                                                                              \
+        elog_ns = now_ns() - elog_ns;                                                                                  \
+        printf("%-12s %10.1f %10.1f %8.2f\n", name, (double)libc_ns / calls, (double)elog_ns / calls,                 \
+               (double)libc_ns / elog_ns);                                                                             \
+    } while (0)
+
+/* check the output only, for the corner cases */
+#define CHECK_CASE(format, ...)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        char expected[64], actual[64];                                                                                 \
+        int  expected_len = call_format(vsnprintf, expected, sizeof(expected), format, __VA_ARGS__);                  \
+        int  actual_len   = call_format(elog_vsnprintf, actual, sizeof(actual), format, __VA_ARGS__);                 \
+                                                                                                                       \
+        if (expected_len != actual_len || strcmp(expected, actual) != 0)                                               \
+        {                                                                                                              \
+            printf("FAIL \"%s\": libc \"%s\" (%d), elog \"%s\" (%d)\n", format, expected, expected_len, actual,       \
+                   actual_len);                                                                                        \
+            failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+static void check_corner_cases (void)
+{
+    char buf[8];
+
+    CHECK_CASE("%d %d %d", 0, -1, INT32_MIN);
+    CHECK_CASE("%u %lu %llu", 4294967295U, 0UL, 18446744073709551615ULL);
+    CHECK_CASE("%lld %jd %zu %td", -9223372036854775807LL - 1, (intmax_t)-5, (size_t)77, (ptrdiff_t)-3);
+    CHECK_CASE("%hhd %hd %hhu %hu", 300, 70000, 300, 70000);
+    CHECK_CASE("[%5d] [%-5d] [%05d] [%+d] [% d] [%+05d]", 42, 42, 42, 42, 42, -42);
+    CHECK_CASE("[%.3d] [%8.3d] [%-8.3d] [%08.3d] [%.0d] [%5.0d]", 7, 7, -7, 7, 0, 0);
+    CHECK_CASE("[%x] [%X] [%#x] [%#X] [%#x] [%08x] [%#010x] [%.4x]", 0xbeefU, 0xbeefU, 255U, 255U, 0U, 0xabcU, 0xabcU, 1U);
+    CHECK_CASE("[%o] [%#o] [%#o] [%#.0o] [%.0o]", 8U, 8U, 0U, 0U, 0U);
+    CHECK_CASE("[%*d] [%-*d] [%*d] [%.*d] [%.*d]", 6, 1, 6, 1, -6, 1, 4, 1, -1, 1);
+    CHECK_CASE("[%s] [%10s] [%-10s] [%.2s] [%*.*s] [%010s]", "abc", "abc", "abc", "abc", 6, 1, "abc", "z");
+    CHECK_CASE("[%c] [%3c] [%-3c] [%%] [%5%]", 'x', 'y', 'z', 0);
+    CHECK_CASE("[%p] [%20p] [%-20p]", (void *)buf, (void *)buf, (void *)buf);
+    CHECK_CASE("[%f] [%.2f] [%10.3f] [%-10.1f] [%010.2f] [%+.1f] [% .1f]", 3.14159, 2.5, -1.0005, 9.96, -3.5, 1.25, 1.25);
+    CHECK_CASE("[%.0f] [%#.0f] [%f] [%F] [%.3f] [%.1f]", 3.7, 3.0, 0.0, -0.0, 1e-7, 0.95);
+    CHECK_CASE("[%f] [%.10f] [%.20f] [%f]", 1e18, 1.0 / 3, 0.5, 123456789.123456789);
+    CHECK_CASE("[%f] [%F] [%5f] [%-6f|]", 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 1.0 / 0.0);
+    CHECK_CASE("[%Lf] [%.2Lf]", (long double)1.5, (long double)-2.25);
+    CHECK_CASE("no conversion %s", "");
+
+    /* truncation and the returned length */
+    char expected[8], actual[8];
+    int  expected_len = call_format(vsnprintf, expected, sizeof(expected), "%s-%d", "truncated", 12345);
+    int  actual_len   = call_format(elog_vsnprintf, actual, sizeof(actual), "%s-%d", "truncated", 12345);
+    if (expected_len != actual_len || strcmp(expected, actual) != 0)
+    {
+        printf("FAIL truncation: libc \"%s\" (%d), elog \"%s\" (%d)\n", expected, expected_len, actual, actual_len);
+        failures++;
+    }
+    if (call_format(elog_vsnprintf, NULL, 0, "%d", 123456) != 6)
+    {
+        printf("FAIL size 0\n");
+        failures++;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        calls = strtol(argv[1], NULL, 0);
+    }
+    if (calls < 1)
+    {
+        fprintf(stderr, "usage: %s [calls_per_case]\n", argv[0]);
+        return 1;
+    }
+
+    check_corner_cases();
+
+    printf("%-12s %10s %10s %8s\n", "case", "libc ns", "elog ns", "speedup");
+    BENCH_CASE("literal", "just a constant message%s", "");
+    BENCH_CASE("int", "value %d", 123456);
+    BENCH_CASE("ints", "%d %u %ld %lu", -42, 4000000000U, -1234567890L, 9876543210UL);
+    BENCH_CASE("hex", "reg 0x%08x addr %p", 0xdeadbeefU, (void *)&calls);
+    BENCH_CASE("string", "%s connected to %-12s port %5u", "eth0", "10.0.0.1", 8080U);
+    BENCH_CASE("float", "temp %.2f volt %f", 36.6, 3.3);
+    BENCH_CASE("typical", "thread %ld log %ld value %08lx %s %.3f", 3L, 123456L, 0xcafef00dUL, "payload", 17.6);
+
+    printf("%s\n", failures ? "output differs" : "output matches libc");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,344 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Indexed binary segments: seek by time, level and seq against a scan of the whole segment.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * The logs are drained into a binary segment of the file sink (lib/plugins/file, ELOG_FILE_BINARY_ENABLE),
+ * one in ERROR_PERIOD is an error. The closed segment is mapped and the errors of a time range are read
+ * with the index and with a scan of every record, both must return the same records. Then seeks by seq
+ * are checked, and the segment without its footer (a crashed writer) is read once more.
+ * The bench Makefile builds it with ELOG_FILE_BINARY_ENABLE.
+ *
+ * Build and run: make -C bench run-seg
+ *
+ * Usage: elog_bench_seg [logs [file]]
+ */
+
+#include <elog.h>
+#include <elog_file.h>
+#include <elog_seg.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_LOGS    100000
+/* logs between two drains, they must fit in the ring buffer */
+#define DRAIN_LOGS      200
+/* one log in so many is an error */
+#define ERROR_PERIOD    1000
+/* time range of the error query, a fraction of the segment */
+#define QUERY_BEGIN     0.40
+#define QUERY_END       0.45
+/* repetitions of the timed queries */
+#define QUERY_REPEAT    20
+/* seqs looked up with elog_seg_seek_seq */
+#define SEEK_NUM        1000
+/* first timestamp of elog_port_get_time, ms */
+#define TIME_START      1792238400000ULL
+#define TIME_STEP       3
+
+ElogErrCode elog_port_init (void)
+{
+    return ELOG_NO_ERR;
+}
+void elog_port_deinit (void)
+{
+}
+void elog_port_output (const char *log, size_t size)
+{
+    elog_file_write(log, size);
+}
+void elog_port_output_batch (const elog_span_t *logs, size_t count)
+{
+    elog_file_write_batch(logs, count);
+}
+bool elog_port_output_lock (void)
+{
+    return true;
+}
+bool elog_port_output_unlock (void)
+{
+    return true;
+}
+bool elog_port_output_lock_isr (void)
+{
+    return true;
+}
+bool elog_port_output_unlock_isr (void)
+{
+    return true;
+}
+elog_timestamp_t elog_port_get_time (void)
+{
+    static uint64_t  ms = TIME_START;
+    elog_timestamp_t timestamp;
+
+    ms += TIME_STEP;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static elog_header_t record_header (const elog_span_t *record)
+{
+    elog_header_t header;
+
+    memcpy(&header, record->data, sizeof(header));
+    return header;
+}
+
+/**
+ * read the records of a filter
+ *
+ * @param seg segment
+ * @param filter filter
+ * @param seqs seqs of the records, NULL: not kept
+ *
+ * @return number of records
+ */
+static size_t query (const elog_seg_t *seg, const elog_seg_filter_t *filter, uint32_t *seqs)
+{
+    elog_seg_iter_t iter;
+    elog_span_t     record;
+    size_t          count = 0;
+
+    elog_seg_iter_init(&iter, seg, filter);
+    while (elog_seg_next(&iter, &record))
+    {
+        if (seqs != NULL)
+        {
+            seqs[count] = record_header(&record).seq_num;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/* time the query with the index and with a scan of every record, the records must be the same */
+static bool bench_query (const elog_seg_t *seg, const elog_seg_filter_t *filter, const char *name)
+{
+    elog_seg_t unindexed = *seg;
+    uint32_t  *indexed_seqs, *scanned_seqs;
+    size_t     indexed, scanned;
+    uint64_t   indexed_ns = 0, scanned_ns = 0;
+
+    unindexed.index     = NULL;
+    unindexed.index_num = 0;
+    indexed_seqs        = malloc(seg->size / sizeof(elog_header_t) * sizeof(uint32_t));
+    scanned_seqs        = malloc(seg->size / sizeof(elog_header_t) * sizeof(uint32_t));
+    indexed             = query(seg, filter, indexed_seqs);
+    scanned             = query(&unindexed, filter, scanned_seqs);
+    for (int i = 0; i < QUERY_REPEAT; i++)
+    {
+        uint64_t start = now_ns();
+        query(seg, filter, NULL);
+        indexed_ns += now_ns() - start;
+        start = now_ns();
+        query(&unindexed, filter, NULL);
+        scanned_ns += now_ns() - start;
+    }
+
+    bool ok = indexed == scanned && memcmp(indexed_seqs, scanned_seqs, indexed * sizeof(uint32_t)) == 0;
+    printf("%-10s %zu records, index %.1f us, scan %.1f us, %.0fx%s\n", name, indexed,
+           indexed_ns / 1e3 / QUERY_REPEAT, scanned_ns / 1e3 / QUERY_REPEAT, (double)scanned_ns / indexed_ns,
+           ok ? "" : " FAIL the records differ");
+    free(indexed_seqs);
+    free(scanned_seqs);
+
+    return ok;
+}
+
+/* seek to seqs and check the record found */
+static bool check_seek_seq (const elog_seg_t *seg, uint32_t first, uint32_t last)
+{
+    elog_seg_iter_t iter;
+    elog_span_t     record;
+    uint64_t        ns = 0;
+
+    elog_seg_iter_init(&iter, seg, NULL);
+    for (uint32_t i = 0; i < SEEK_NUM; i++)
+    {
+        uint32_t seq   = first + (uint32_t)((uint64_t)(last - first) * i / SEEK_NUM);
+        uint64_t start = now_ns();
+
+        elog_seg_seek_seq(&iter, seq);
+        ns += now_ns() - start;
+        if (!elog_seg_next(&iter, &record) || record_header(&record).seq_num != seq)
+        {
+            printf("FAIL seek to seq %u\n", seq);
+            return false;
+        }
+    }
+    printf("seek seq   %d seeks, %.0f ns each\n", SEEK_NUM, (double)ns / SEEK_NUM);
+
+    return true;
+}
+
+int main (int argc, char *argv[])
+{
+    long        logs = DEFAULT_LOGS;
+    const char *name = "elog_bench_seg.bin";
+    bool        ok   = true;
+
+    if (argc > 1)
+    {
+        logs = strtol(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        name = argv[2];
+    }
+    if (logs < 1)
+    {
+        fprintf(stderr, "usage: %s [logs [file]]\n", argv[0]);
+        return 1;
+    }
+
+    elog_file_cfg_t cfg = {.name          = name,
+                           .max_size      = ELOG_FILE_MAX_SIZE,
+                           .max_rotate    = 0,
+                           .rotate_period = 0,
+                           .sync_period   = ELOG_FILE_SYNC_PERIOD};
+    elog_file_config(&cfg);
+    elog_init();
+    elog_start();
+    elog_async_output_batch(SIZE_MAX);
+    unlink(name);
+    elog_file_init();
+
+    uint64_t start = now_ns();
+    for (long i = 0; i < logs; i += DRAIN_LOGS)
+    {
+        for (long j = i; j < i + DRAIN_LOGS && j < logs; j++)
+        {
+            if (j % ERROR_PERIOD == ERROR_PERIOD - 1)
+            {
+                elog_e("seg", "crc error on frame %ld", j);
+            }
+            else
+            {
+                elog_i("seg", "rx frame %ld len %ld crc ok", j, 64 + j % 1400);
+            }
+        }
+        elog_async_output_batch(SIZE_MAX);
+    }
+    elog_file_deinit();
+    double write_ns = (double)(now_ns() - start) / logs;
+
+    int         fd = open(name, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "can't open %s\n", name);
+        return 1;
+    }
+    const char *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    elog_seg_t seg;
+    if (data == MAP_FAILED || elog_seg_open(&seg, data, (size_t)st.st_size) != ELOG_NO_ERR || seg.index == NULL)
+    {
+        fprintf(stderr, "%s isn't a closed segment, it may have rotated (fewer logs)\n", name);
+        return 1;
+    }
+    printf("write      %ld logs, %.0f ns/log, %ld bytes, %zu index entries, %zu sites\n", logs, write_ns,
+           (long)st.st_size, seg.index_num, seg.site_num);
+
+    /* every record is there in order */
+    elog_seg_iter_t iter;
+    elog_span_t     record;
+    long            count = 0;
+    uint32_t        first = 0, last = 0;
+    elog_seg_iter_init(&iter, &seg, NULL);
+    while (elog_seg_next(&iter, &record))
+    {
+        uint32_t seq = record_header(&record).seq_num;
+        if (count == 0)
+        {
+            first = seq;
+        }
+        else if (seq != last + 1)
+        {
+            printf("FAIL seq %u after %u\n", seq, last);
+            ok = false;
+        }
+        last = seq;
+        count++;
+    }
+    elog_seg_site_t site;
+    if (count != logs || !elog_seg_find_site(&seg, record_header(&record).site_id, &site) || strcmp(site.tag, "seg") != 0)
+    {
+        printf("FAIL %ld records, site of the last one\n", count);
+        ok = false;
+    }
+
+    /* errors of a time range */
+    uint64_t          span   = (uint64_t)(logs + 2) * TIME_STEP;
+    elog_seg_filter_t filter = {.time_begin = TIME_START + (uint64_t)(span * QUERY_BEGIN),
+                                .time_end   = TIME_START + (uint64_t)(span * QUERY_END),
+                                .levels     = ELOG_SEG_LVL(ELOG_LVL_ASSERT) | ELOG_SEG_LVL(ELOG_LVL_ERROR)};
+    ok = bench_query(&seg, &filter, "errors") && ok;
+    filter.levels = ELOG_SEG_LVL_ALL;
+    ok = bench_query(&seg, &filter, "range") && ok;
+
+    ok = check_seek_seq(&seg, first, last) && ok;
+
+    /* without the footer and with a torn last record */
+    elog_seg_t torn;
+    size_t     torn_size = seg.records_end - 5;
+    elog_seg_open(&torn, data, torn_size);
+    count = (long)query(&torn, NULL, NULL);
+    if (torn.index != NULL || count != logs - 1)
+    {
+        printf("FAIL %ld records without the footer\n", count);
+        ok = false;
+    }
+    else
+    {
+        printf("torn       %ld records without the footer\n", count);
+    }
+
+    munmap((void *)data, (size_t)st.st_size);
+    unlink(name);
+    printf("%s\n", ok ? "segment matches the logs" : "segment differs");
+    return ok ? 0 : 1;
+}
@@ -37,6 +37,34 @@
 /* EasyLogger software version number */
 #define ELOG_SW_VERSION "2.2.99"
 
+/* buffer size for every line's log, task context callers need this much stack with ELOG_LINE_BUF_ON_STACK */
+#ifndef ELOG_LINE_BUF_SIZE
+    #define ELOG_LINE_BUF_SIZE 1024
+#endif
+
+/* ISR lane size of asynchronous output mode, interrupt logs go there without taking the output lock,
+ * 0: interrupt logs share the task lanes and the output lock */
+#ifndef ELOG_ASYNC_ISR_BUF_SIZE
+    #define ELOG_ASYNC_ISR_BUF_SIZE 0
+#endif
+/* buffer size for every ISR lane log, it is on the interrupt stack */
+#ifndef ELOG_ASYNC_ISR_LINE_BUF_SIZE
+    #define ELOG_ASYNC_ISR_LINE_BUF_SIZE 128
+#endif
+/* interrupts that may log on the ISR lane at the same time, nested or on other cores, more are dropped */
+#ifndef ELOG_ASYNC_ISR_NEST_MAX
+    #define ELOG_ASYNC_ISR_NEST_MAX 4
+#endif
+
+/* output filter's tag max length */
+#ifndef ELOG_FILTER_TAG_MAX_LEN
+    #define ELOG_FILTER_TAG_MAX_LEN 30
+#endif
+/* output filter's tag level max num */
+#ifndef ELOG_FILTER_TAG_LVL_MAX_NUM
+    #define ELOG_FILTER_TAG_LVL_MAX_NUM 8
+#endif
+
 /* output log's level */
 #define ELOG_LVL_TOTAL_NUM        6
 #define ELOG_LVL_ASSERT           0
@@ -46,25 +74,233 @@
 #define ELOG_LVL_DEBUG            4
 #define ELOG_LVL_VERBOSE          5
 
-#define elog_assert(tag, ...)     elog_output(false, ELOG_LVL_ASSERT, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+/* the output silent level and all level for filter setting */
+#define ELOG_FILTER_LVL_SILENT    ELOG_LVL_ASSERT
+#define ELOG_FILTER_LVL_ALL       ELOG_LVL_VERBOSE
+
+/* linker section of the call-site descriptors, a custom linker script has to keep it and provide
+ * __start_elog_sites / __stop_elog_sites (GNU ld does so automatically) */
+#define ELOG_SITE_SECTION         "elog_sites"
+/* call-site id for records without a descriptor */
+#define ELOG_SITE_ID_NONE         0xFFFF
+
+/* mutable call-site state, one static instance per log macro expansion */
+typedef struct
+{
+    uint32_t filter; /* cached filter decision, the filter generation it was made in with the enabled flag in bit 0 */
+#if defined(ELOG_RATE_LIMIT_ENABLE)
+    uint32_t bucket;     /* token bucket, refill time and tokens */
+    uint32_t suppressed; /* logs suppressed since the last output */
+#endif
+} elog_site_state_t;
+
+/* call-site descriptor, one static instance per log macro expansion */
+typedef struct
+{
+    const char        *tag;
+    const char        *file;
+    const char        *func;
+    long               line;
+    uint8_t            level;
+    elog_site_state_t *state;
+} elog_site_t;
+
+#define ELOG_SITE_ATTR            __attribute__((section(ELOG_SITE_SECTION), used, aligned(sizeof(void *))))
+
+/* static output level, logs above it are compiled out and their args are never evaluated.
+ * A source file can override it by defining LOG_LVL before including elog.h, usually next to its LOG_TAG. */
+#if defined(LOG_LVL)
+    #define ELOG_STATIC_LVL LOG_LVL
+#elif defined(ELOG_OUTPUT_LVL)
+    #define ELOG_STATIC_LVL ELOG_OUTPUT_LVL
+#else
+    #define ELOG_STATIC_LVL ELOG_LVL_VERBOSE
+#endif
+
+/* filter generation, it is even and moves on every time the level or tag filter changes */
+extern uint32_t elog_filter_gen;
+
+bool elog_site_refresh (const elog_site_t *site);
+
+/**
+ * check the call site against the runtime level and tag filter
+ * The decision is cached per call site until the filter changes, so this is one compare in the common case.
+ *
+ * @param site call-site descriptor
+ *
+ * @return true when the log should be output
+ */
+static inline bool elog_site_enabled (const elog_site_t *site)
+{
+    uint32_t filter = __atomic_load_n(&site->state->filter, __ATOMIC_RELAXED);
+
+    if ((filter | 1) == (__atomic_load_n(&elog_filter_gen, __ATOMIC_RELAXED) | 1))
+    {
+        return filter & 1;
+    }
+
+    return elog_site_refresh(site);
+}
+
+/* emit the call-site descriptor and output the log, the tag must be a constant string */
+#define elog_output_site(is_isr, lvl, tag, ...)                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        static elog_site_state_t                elog_site_state_;                                                      \
+        ELOG_SITE_ATTR static const elog_site_t elog_site_ = {(tag), __FILE__, __FUNCTION__, __LINE__, (lvl),          \
+                                                              &elog_site_state_};                                      \
+        if (elog_site_enabled(&elog_site_))                                                                            \
+        {                                                                                                              \
+            elog_output((is_isr), &elog_site_, __VA_ARGS__);                                                           \
+        }                                                                                                              \
+    } while (0)
+
+/* compiled out log */
+#define elog_output_none(...)      do {} while (0)
+
+#if ELOG_STATIC_LVL >= ELOG_LVL_ASSERT
+    #define elog_assert(tag, ...)      elog_output_site(false, ELOG_LVL_ASSERT, tag, __VA_ARGS__)
+    #define elog_assert_isr(tag, ...)  elog_output_site(true, ELOG_LVL_ASSERT, tag, __VA_ARGS__)
+#else
+    #define elog_assert(tag, ...)      elog_output_none(tag, __VA_ARGS__)
+    #define elog_assert_isr(tag, ...)  elog_output_none(tag, __VA_ARGS__)
+#endif
+
+#if ELOG_STATIC_LVL >= ELOG_LVL_ERROR
+    #define elog_error(tag, ...)       elog_output_site(false, ELOG_LVL_ERROR, tag, __VA_ARGS__)
+    #define elog_error_isr(tag, ...)   elog_output_site(true, ELOG_LVL_ERROR, tag, __VA_ARGS__)
+#else
+    #define elog_error(tag, ...)       elog_output_none(tag, __VA_ARGS__)
+    #define elog_error_isr(tag, ...)   elog_output_none(tag, __VA_ARGS__)
+#endif
+
+#if ELOG_STATIC_LVL >= ELOG_LVL_WARN
+    #define elog_warn(tag, ...)        elog_output_site(false, ELOG_LVL_WARN, tag, __VA_ARGS__)
+    #define elog_warn_isr(tag, ...)    elog_output_site(true, ELOG_LVL_WARN, tag, __VA_ARGS__)
+#else
+    #define elog_warn(tag, ...)        elog_output_none(tag, __VA_ARGS__)
+    #define elog_warn_isr(tag, ...)    elog_output_none(tag, __VA_ARGS__)
+#endif
+
+#if ELOG_STATIC_LVL >= ELOG_LVL_INFO
+    #define elog_info(tag, ...)        elog_output_site(false, ELOG_LVL_INFO, tag, __VA_ARGS__)
+    #define elog_info_isr(tag, ...)    elog_output_site(true, ELOG_LVL_INFO, tag, __VA_ARGS__)
+#else
+    #define elog_info(tag, ...)        elog_output_none(tag, __VA_ARGS__)
+    #define elog_info_isr(tag, ...)    elog_output_none(tag, __VA_ARGS__)
+#endif
+
+#if ELOG_STATIC_LVL >= ELOG_LVL_DEBUG
+    #define elog_debug(tag, ...)       elog_output_site(false, ELOG_LVL_DEBUG, tag, __VA_ARGS__)
+    #define elog_debug_isr(tag, ...)   elog_output_site(true, ELOG_LVL_DEBUG, tag, __VA_ARGS__)
+#else
+    #define elog_debug(tag, ...)       elog_output_none(tag, __VA_ARGS__)
+    #define elog_debug_isr(tag, ...)   elog_output_none(tag, __VA_ARGS__)
+#endif
 
-#define elog_assert_isr(tag, ...) elog_output(true, ELOG_LVL_ASSERT, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#if ELOG_STATIC_LVL >= ELOG_LVL_VERBOSE
+    #define elog_verbose(tag, ...)     elog_output_site(false, ELOG_LVL_VERBOSE, tag, __VA_ARGS__)
+    #define elog_verbose_isr(tag, ...) elog_output_site(true, ELOG_LVL_VERBOSE, tag, __VA_ARGS__)
+#else
+    #define elog_verbose(tag, ...)     elog_output_none(tag, __VA_ARGS__)
+    #define elog_verbose_isr(tag, ...) elog_output_none(tag, __VA_ARGS__)
+#endif
 
-#define elog_error(tag, ...)      elog_output(false, ELOG_LVL_ERROR, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define elog_error_isr(tag, ...)  elog_output(true, ELOG_LVL_ERROR, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#if defined(ELOG_HEXDUMP_ENABLE)
+/* bytes per hexdump line */
+#ifndef ELOG_HEXDUMP_WIDTH
+    #define ELOG_HEXDUMP_WIDTH 16
+#endif
+/* rendered hexdump line: offset, bytes in hex, bytes in ASCII and the newline sign */
+#define ELOG_HEXDUMP_LINE_LEN   (13 + ELOG_HEXDUMP_WIDTH * 4 + sizeof(ELOG_NEWLINE_SIGN) - 1)
+/* bytes of a hexdump record, its rendered lines fill a line buffer, longer dumps go on in more records */
+#define ELOG_HEXDUMP_CHUNK_SIZE ((ELOG_LINE_BUF_SIZE - sizeof(elog_header_t) - 1) / ELOG_HEXDUMP_LINE_LEN * ELOG_HEXDUMP_WIDTH)
 
-#define elog_warn(tag, ...)       elog_output(false, ELOG_LVL_WARN, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define elog_warn_isr(tag, ...)   elog_output(true, ELOG_LVL_WARN, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+/* emit the call-site descriptor and output a hexdump, the tag must be a constant string */
+#define elog_hexdump(tag, lvl, buf, size)                                                                              \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        static elog_site_state_t                elog_site_state_;                                                      \
+        ELOG_SITE_ATTR static const elog_site_t elog_site_ = {(tag), __FILE__, __FUNCTION__, __LINE__, (lvl),          \
+                                                              &elog_site_state_};                                      \
+        if ((lvl) <= ELOG_STATIC_LVL && elog_site_enabled(&elog_site_))                                                \
+        {                                                                                                              \
+            elog_hexdump_output(&elog_site_, (buf), (size));                                                           \
+        }                                                                                                              \
+    } while (0)
+#endif /* ELOG_HEXDUMP_ENABLE */
 
-#define elog_info(tag, ...)       elog_output(false, ELOG_LVL_INFO, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define elog_info_isr(tag, ...)   elog_output(true, ELOG_LVL_INFO, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#if defined(ELOG_KV_ENABLE)
+/* structured log field types */
+#define ELOG_KV_U32  0
+#define ELOG_KV_I32  1
+#define ELOG_KV_U64  2
+#define ELOG_KV_I64  3
+#define ELOG_KV_F64  4
+#define ELOG_KV_BOOL 5
+#define ELOG_KV_STR  6 /* the string is copied, it may be gone when the record is drained */
 
-#define elog_debug(tag, ...)      elog_output(false, ELOG_LVL_DEBUG, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define elog_debug_isr(tag, ...)  elog_output(true, ELOG_LVL_DEBUG, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+/* structured log field, the key text is copied into the record */
+typedef struct
+{
+    const char *key;
+    uint8_t     type;
+    union
+    {
+        uint32_t    u32;
+        int32_t     i32;
+        uint64_t    u64;
+        int64_t     i64;
+        double      f64;
+        bool        b;
+        const char *str;
+    } value;
+} elog_kv_t;
+
+#define ELOG_U32(key, v)  ((elog_kv_t){(key), ELOG_KV_U32, {.u32 = (uint32_t)(v)}})
+#define ELOG_I32(key, v)  ((elog_kv_t){(key), ELOG_KV_I32, {.i32 = (int32_t)(v)}})
+#define ELOG_U64(key, v)  ((elog_kv_t){(key), ELOG_KV_U64, {.u64 = (uint64_t)(v)}})
+#define ELOG_I64(key, v)  ((elog_kv_t){(key), ELOG_KV_I64, {.i64 = (int64_t)(v)}})
+#define ELOG_F64(key, v)  ((elog_kv_t){(key), ELOG_KV_F64, {.f64 = (double)(v)}})
+#define ELOG_BOOL(key, v) ((elog_kv_t){(key), ELOG_KV_BOOL, {.b = (v) ? true : false}})
+#define ELOG_STR(key, v)  ((elog_kv_t){(key), ELOG_KV_STR, {.str = (v)}})
+
+/* emit the call-site descriptor and output the fields as a structured log, the tag must be a constant string */
+#define elog_kv(tag, lvl, ...)                                                                                         \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        static elog_site_state_t                elog_site_state_;                                                      \
+        ELOG_SITE_ATTR static const elog_site_t elog_site_ = {(tag), __FILE__, __FUNCTION__, __LINE__, (lvl),          \
+                                                              &elog_site_state_};                                      \
+        if ((lvl) <= ELOG_STATIC_LVL && elog_site_enabled(&elog_site_))                                                \
+        {                                                                                                              \
+            const elog_kv_t elog_kv_fields_[] = {__VA_ARGS__};                                                         \
+            elog_kv_output(&elog_site_, elog_kv_fields_, sizeof(elog_kv_fields_) / sizeof(elog_kv_fields_[0]));        \
+        }                                                                                                              \
+    } while (0)
+#endif /* ELOG_KV_ENABLE */
+
+/* log prefix fields of elog_render, a set per level is selected with elog_set_fmt */
+typedef enum
+{
+    ELOG_FMT_ALL  = 0x7F,
+    ELOG_FMT_TIME = 1 << 0, /* timestamp, date and time text from elog_port_fmt_time and milliseconds */
+    ELOG_FMT_SEQ  = 1 << 1, /* sequence number */
+    ELOG_FMT_LVL  = 1 << 2, /* level */
+    ELOG_FMT_TAG  = 1 << 3, /* tag */
+    ELOG_FMT_DIR  = 1 << 4, /* source file */
+    ELOG_FMT_FUNC = 1 << 5, /* function name */
+    ELOG_FMT_LINE = 1 << 6, /* line number */
+} ElogFmtIndex;
 
-#define elog_verbose(tag, ...)    elog_output(false, ELOG_LVL_VERBOSE, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define elog_verbose_isr(tag, ...)                                                                                     \
-    elog_output(true, ELOG_LVL_VERBOSE, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+/* format set of every level until elog_set_fmt changes it */
+#ifndef ELOG_FMT_DEFAULT
+    #define ELOG_FMT_DEFAULT (ELOG_FMT_TIME | ELOG_FMT_LVL | ELOG_FMT_TAG)
+#endif
+/* elog_port_get_time ticks per second, elog_render splits the timestamp into seconds and milliseconds */
+#ifndef ELOG_FMT_TIME_FREQ
+    #define ELOG_FMT_TIME_FREQ 1000
+#endif
 
 /* easy logger */
 typedef struct
@@ -95,10 +331,28 @@ void        elog_stop (void);
 void        elog_set_output_enabled (bool enabled);
 bool        elog_get_output_enabled (void);
 void        elog_set_fmt (uint8_t level, size_t set);
-void   elog_output (bool is_isr, uint8_t level, const char *tag, const char *file, const char *func, const long line,
-                    const char *format, ...);
-void   elog_output_lock_enabled (bool enabled);
-int8_t elog_find_lvl (const char *log);
+void        elog_output (bool is_isr, const elog_site_t *site, const char *format, ...);
+void        elog_output_lock_enabled (bool enabled);
+uint16_t           elog_site_id (const elog_site_t *site);
+const elog_site_t *elog_find_site (uint16_t site_id);
+void               elog_rate_limit_flush (void);
+uint32_t           elog_get_drop_count (void);
+#if defined(ELOG_HEXDUMP_ENABLE)
+void               elog_hexdump_output (const elog_site_t *site, const void *buf, size_t size);
+#endif
+#if defined(ELOG_KV_ENABLE)
+void               elog_kv_output (const elog_site_t *site, const elog_kv_t *fields, size_t num);
+
+/* elog_kv.c */
+void               elog_set_kv_json (bool enabled);
+#endif
+
+/* elog_filter.c */
+void        elog_set_filter_lvl (uint8_t level);
+uint8_t     elog_get_filter_lvl (void);
+ElogErrCode elog_set_filter_tag_lvl (const char *tag, uint8_t level);
+uint8_t     elog_get_filter_tag_lvl (const char *tag);
+int8_t      elog_find_lvl (const char *log);
 const char *elog_find_tag (const char *log, uint8_t lvl, size_t *tag_len);
 
 #define elog_a(tag, ...) elog_assert(tag, __VA_ARGS__)
@@ -116,9 +370,51 @@ const char *elog_find_tag (const char *log, uint8_t lvl, size_t *tag_len);
 #define elog_d_isr(tag, ...) elog_debug_isr(tag, __VA_ARGS__)
 #define elog_v_isr(tag, ...) elog_verbose_isr(tag, __VA_ARGS__)
 
+/* asynchronous output ring buffer overflow policy */
+#define ELOG_ASYNC_OVERFLOW_DROP_NEWEST      0 /* drop the new log */
+#define ELOG_ASYNC_OVERFLOW_OVERWRITE_OLDEST 1 /* evict the oldest logs until the new one fits */
+#define ELOG_ASYNC_OVERFLOW_BLOCK            2 /* wait for the drain up to ELOG_ASYNC_BLOCK_TIMEOUT, interrupts drop */
+
+/* contiguous log record (header and message) handed out in place */
+typedef struct
+{
+    const char *data;
+    size_t      size;
+} elog_span_t;
+
 /* elog_async.c */
 void        elog_async_enabled (bool enabled);
 ElogErrCode elog_async_get_line_log (char *log, size_t size);
+ElogErrCode elog_async_peek_line_log (const char **log, size_t *size);
+void        elog_async_release_line_log (void);
+size_t      elog_async_peek_line_logs (elog_span_t *logs, size_t max_count);
+void        elog_async_release_line_logs (size_t count);
+size_t      elog_async_output_batch (size_t max_count);
+
+/* latency histogram buckets, bucket 0 counts 0 and bucket n counts [2^(n-1), 2^n), the last one is open */
+#define ELOG_STATS_HIST_NUM    32
+/* asynchronous output lanes in elog_stats_t.ring_peak */
+#define ELOG_STATS_LANE_ISR    0
+#define ELOG_STATS_LANE_HIGH   1
+#define ELOG_STATS_LANE_OUTPUT 2
+#define ELOG_STATS_LANE_NUM    3
+
+/* logger self-instrumentation, counted with ELOG_STATS_ENABLE, every counter wraps around */
+typedef struct
+{
+    uint32_t records;     /* logs handed to the output or the ring buffer */
+    uint32_t bytes;       /* bytes of those records, header and message */
+    uint32_t ring_drops;  /* logs dropped or evicted because the ring buffer was full */
+    uint32_t lock_fails;  /* logs dropped because the output lock was taken */
+    uint32_t truncations; /* messages cut because they were longer than ELOG_LINE_BUF_SIZE */
+    uint32_t ring_peak[ELOG_STATS_LANE_NUM];    /* most bytes each lane held */
+    uint32_t output_time[ELOG_STATS_HIST_NUM];  /* elog_output time, elog_port_stats_time units */
+    uint32_t drain_time[ELOG_STATS_HIST_NUM];   /* elog_port_output_batch time, elog_port_stats_time units */
+} elog_stats_t;
+
+/* elog_stats.c */
+void        elog_get_stats (elog_stats_t *stats);
+void        elog_stats_output (void);
 
 // 64bit timestamp
 typedef struct
@@ -127,12 +423,71 @@ typedef struct
     uint32_t high;
 } elog_timestamp_t;
 
+/* log record type */
+#define ELOG_RECORD_TEXT          0 /* formatted text message */
+#define ELOG_RECORD_DEFERRED      1 /* format pointer and raw args, rendered on drain */
+#define ELOG_RECORD_GAP           2 /* number of logs dropped in front of this record, rendered on drain */
+#define ELOG_RECORD_HEX           3 /* offset and raw bytes of elog_hexdump, rendered on drain */
+#define ELOG_RECORD_KV            4 /* typed fields of elog_kv, rendered on drain */
+#define ELOG_RECORD_CALIB         5 /* wall time at the counter of the timestamp, see elog_time.c */
+#define ELOG_RECORD_SKIP          0xFF /* ring buffer padding up to the wrap around, never drained */
+
 typedef struct
 {
     uint32_t         seq_num;
     uint8_t          level;
+    uint8_t          type;
+    uint16_t         site_id; /* resolve with elog_find_site */
     elog_timestamp_t timestamp;
     uint32_t         message_length;
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+    uint16_t         magic;    /* ELOG_RECORD_MAGIC once the record is in the ring buffer */
+    uint16_t         checksum; /* of the header and message, set with the magic */
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
 } elog_header_t;
 
+/* magic of a sealed record in a persistent ring buffer */
+#define ELOG_RECORD_MAGIC 0xE10C
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/* elog_port_get_counter ticks per second, the wall time is taken from it until the second calibration record */
+#ifndef ELOG_TIME_COUNTER_FREQ
+    #define ELOG_TIME_COUNTER_FREQ 1000000000
+#endif
+/* counter ticks between two calibration records */
+#ifndef ELOG_TIME_CALIB_PERIOD
+    #define ELOG_TIME_CALIB_PERIOD ELOG_TIME_COUNTER_FREQ
+#endif
+
+/* counter to wall time conversion of a consumer, zeroed before the first calibration record */
+typedef struct
+{
+    uint64_t counter; /* counter of the last calibration record */
+    uint64_t time;    /* its wall time, elog_port_get_time ticks */
+    double   ratio;   /* wall time ticks per counter tick */
+    bool     valid;   /* a calibration record was taken */
+} elog_calib_t;
+
+/* elog_time.c */
+void             elog_calib_update (elog_calib_t *calib, const char *record);
+elog_timestamp_t elog_calib_time (const elog_calib_t *calib, elog_timestamp_t counter);
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+
+/* elog_render.c */
+size_t elog_render_prefix (const elog_header_t *header, char *prefix, size_t size);
+size_t elog_render (const char *record, size_t size, char *line, size_t line_size);
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+void   elog_render_calibrate (const char *record);
+#endif
+
+/* header of a compressed drain output frame and the largest frame of a block, see elog_lz.c */
+#define ELOG_LZ_FRAME_HEADER_SIZE 10
+#define ELOG_LZ_FRAME_SIZE(block_size) (ELOG_LZ_FRAME_HEADER_SIZE + (block_size))
+
+/* elog_lz.c */
+size_t elog_lz_compress (const char *src, size_t size, char *dst, size_t capacity);
+size_t elog_lz_decompress (const char *src, size_t size, char *dst, size_t capacity);
+size_t elog_lz_frame_encode (const char *block, size_t size, char *frame, size_t capacity);
+size_t elog_lz_frame_decode (const char *stream, size_t size, size_t *consumed, char *block, size_t capacity);
+
 #endif
\ No newline at end of file
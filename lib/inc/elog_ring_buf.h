@@ -1,17 +1,126 @@
 #ifndef _ELOG_BUF_H
 #define _ELOG_BUF_H
 
+#include <elog.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
 
-size_t elog_buf_used(void);
+/*
+ * A ring buffer is lock-free for one producer and one consumer. Producers must be serialized
+ * by the caller (elog_output holds the output lock while pushing), while the single consumer
+ * (elog_async_get_line_log) may run concurrently without taking any lock. Producers that can't
+ * be serialized (interrupts) use elog_buf_push_shared instead, which claims space with a CAS.
+ * Every record (elog_header_t and payload) is stored contiguously, so both sides can work in place
+ * with elog_buf_reserve/elog_buf_commit and elog_buf_peek_span/elog_buf_release.
+ * With ELOG_ASYNC_COMPACT_HEADER_ENABLE the header is stored compact instead, as deltas to the record
+ * in front of it with a full keyframe every ELOG_ASYNC_KEYFRAME_PERIOD records, and the consumer gets
+ * it back with elog_buf_decode.
+ * With ELOG_ASYNC_PERSIST_ENABLE every header is sealed with ELOG_RECORD_MAGIC and a checksum before it
+ * is published, so a ring buffer in storage that survives a reset can be taken over by elog_buf_recover.
+ */
 
-size_t elog_buf_avail(void);
+/* cache line size, the ring indices are kept on separate lines to avoid false sharing */
+#ifndef ELOG_CACHE_LINE_SIZE
+    #define ELOG_CACHE_LINE_SIZE 64
+#endif /* ELOG_CACHE_LINE_SIZE */
 
-int elog_buf_push(const char *log, uint16_t size);
+typedef struct
+{
+    _Alignas(ELOG_CACHE_LINE_SIZE) atomic_size_t index;
+} elog_ring_index_t;
 
-int elog_buf_pop(char *log, uint16_t size);
+/* records from one keyframe to the next with ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+#ifndef ELOG_ASYNC_KEYFRAME_PERIOD
+    #define ELOG_ASYNC_KEYFRAME_PERIOD 16
+#endif /* ELOG_ASYNC_KEYFRAME_PERIOD */
+
+/* most records elog_buf_evict evicts at once, compact headers are evicted up to the next keyframe */
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    #define ELOG_RING_EVICT_MAX ELOG_ASYNC_KEYFRAME_PERIOD
+#else
+    #define ELOG_RING_EVICT_MAX 1
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+
+/* the record the deltas of a compact header refer to */
+typedef struct
+{
+    uint32_t seq_num;
+    uint64_t time;
+} elog_ring_base_t;
+
+typedef struct
+{
+    /* published records end here, advanced by the producer */
+    elog_ring_index_t write_index;
+    /* read index shifted left by one, its low bit is set while the consumer holds the top record */
+    elog_ring_index_t read_index;
+    /* claimed space ends here, elog_buf_push_shared only */
+    elog_ring_index_t claim_index;
+    /* producers between claim and publish, elog_buf_push_shared only */
+    atomic_uint writers;
+    /* storage, aligned to elog_header_t */
+    char  *buf;
+    size_t size;
+    /* slot handed out by elog_buf_reserve, producer only */
+    size_t reserve_index;
+    size_t reserve_capacity;
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    /* last record written and the records until the next keyframe (0: the next one is), producer only */
+    elog_ring_base_t encode_base;
+    uint32_t         encode_count;
+    /* record in front of the top one, consumer only */
+    elog_ring_base_t read_base;
+    /* last record elog_buf_decode decoded and the top record of the last peek, consumer only */
+    elog_ring_base_t decode_base;
+    const char      *decode_top;
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+} elog_ring_buf_t;
+
+/* static initializer for a ring buffer on the given storage array */
+#define ELOG_RING_BUF_INIT(storage) { .buf = (storage), .size = sizeof(storage) }
+
+void elog_buf_init(elog_ring_buf_t *ring, char *buf, size_t size);
+
+// Take over a ring buffer left in persistent storage by the previous boot, its records are validated
+size_t elog_buf_recover(elog_ring_buf_t *ring, char *buf, size_t size, uint32_t *newest_seq);
+
+size_t elog_buf_used(elog_ring_buf_t *ring);
+
+size_t elog_buf_avail(elog_ring_buf_t *ring);
+
+int elog_buf_push(elog_ring_buf_t *ring, const char *log, size_t size);
+
+// Push from any number of unserialized producers, e.g. nested interrupts
+int elog_buf_push_shared(elog_ring_buf_t *ring, const char *log, size_t size);
+
+// Reserve a contiguous slot and publish the record written into it
+char *elog_buf_reserve(elog_ring_buf_t *ring, size_t size, size_t *capacity);
+
+int elog_buf_commit(elog_ring_buf_t *ring, size_t size);
+
+// Evict the oldest records to make room, producer only
+size_t elog_buf_evict(elog_ring_buf_t *ring, elog_span_t *records, size_t max_count);
+
+// Pop the top record, the buffer size must be at least the record size
+int elog_buf_pop(elog_ring_buf_t *ring, char *log, size_t size);
+
+// Get the top record in place and release it after it was consumed
+int elog_buf_peek_span(elog_ring_buf_t *ring, const char **record, size_t *size);
+
+void elog_buf_release(elog_ring_buf_t *ring, size_t size);
+
+// Get up to max_count records in place and release them after they were consumed
+size_t elog_buf_peek_batch(elog_ring_buf_t *ring, elog_span_t *records, size_t max_count);
+
+void elog_buf_release_batch(elog_ring_buf_t *ring, size_t count);
+
+// Decode the header of a peeked record, the records behind the top one in the order they were peeked
+size_t elog_buf_decode(elog_ring_buf_t *ring, const char *record, elog_header_t *header);
+
+// Decode a header without the consumer's base, the sequence number and timestamp of a delta stay deltas
+size_t elog_buf_parse(const char *record, elog_header_t *header);
 
 // Peek the top log in the buffer
-int elog_buf_peek(elog_header_t *header);
-#endif // _ELOG_BUF_H
\ No newline at end of file
+int elog_buf_peek(elog_ring_buf_t *ring, elog_header_t *header);
+#endif // _ELOG_BUF_H
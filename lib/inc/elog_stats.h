@@ -0,0 +1,47 @@
+#ifndef _ELOG_STATS_H
+#define _ELOG_STATS_H
+
+#include <elog.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*
+ * Logger self-instrumentation counters, only compiled in with ELOG_STATS_ENABLE. Every counter is a
+ * relaxed atomic, so tasks, interrupts and the drain count without a lock. elog_get_stats copies them.
+ */
+
+#if defined(ELOG_STATS_ENABLE)
+typedef struct
+{
+    _Atomic uint32_t records;
+    _Atomic uint32_t bytes;
+    _Atomic uint32_t ring_drops;
+    _Atomic uint32_t lock_fails;
+    _Atomic uint32_t truncations;
+    _Atomic uint32_t ring_peak[ELOG_STATS_LANE_NUM];
+    _Atomic uint32_t output_time[ELOG_STATS_HIST_NUM];
+    _Atomic uint32_t drain_time[ELOG_STATS_HIST_NUM];
+} elog_stats_counter_t;
+
+extern elog_stats_counter_t elog_stats_counter;
+
+// Add n to a counter
+#define ELOG_STATS_ADD(counter, n) \
+    atomic_fetch_add_explicit(&elog_stats_counter.counter, (n), memory_order_relaxed)
+
+// Raise the high-watermark of a lane
+void elog_stats_peak(uint8_t lane, size_t used);
+
+// Get the time for the latency histograms
+uint32_t elog_stats_time(void);
+
+// Count the time since start in a latency histogram
+void elog_stats_hist(_Atomic uint32_t *hist, uint32_t start);
+
+// Output the counters when ELOG_STATS_OUTPUT_PERIOD has passed, drain only
+void elog_stats_poll(void);
+#else
+#define ELOG_STATS_ADD(counter, n) ((void)0)
+#endif /* ELOG_STATS_ENABLE */
+
+#endif // _ELOG_STATS_H
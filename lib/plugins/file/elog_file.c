@@ -0,0 +1,569 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: File sink: block writes, preallocated and rotated segments, group commit.
+ * Created on: 2026-10-17
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* fallocate */
+#endif
+
+#include <elog_file.h>
+#include <elog_seg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * The rendered lines are gathered in a block of ELOG_FILE_BLOCK_SIZE. A full block is written with one
+ * pwrite at its block aligned segment offset, so the page cache takes whole pages. A commit writes the
+ * part of the block that wasn't written yet and calls fdatasync: it happens ELOG_FILE_SYNC_PERIOD after
+ * the oldest log that isn't on disk yet, with a batch that holds a log at ELOG_FILE_SYNC_LVL or more
+ * severe, and before a rotation. Logs between two commits share one fdatasync.
+ * A segment is preallocated up to the maximum size without changing the file size, and the rest is
+ * released when it is rotated out. A segment that exists at start is continued.
+ * With ELOG_FILE_BINARY_ENABLE the records are written as they are into indexed segments (elog_seg.h),
+ * the index is kept in memory and written with the footer when the segment is closed. A segment that
+ * exists at start is rotated out, it may be one without a footer.
+ */
+
+/* longest rendered line, lines that don't fit in the rest of the block are rendered here first */
+#define LINE_MAX_LEN (ELOG_LINE_BUF_SIZE + 256)
+/* longest segment name, the rotation number included */
+#define NAME_MAX_LEN 256
+
+#if ELOG_FILE_BLOCK_SIZE < LINE_MAX_LEN
+    #error "ELOG_FILE_BLOCK_SIZE must hold a whole line"
+#endif
+
+#if defined(ELOG_FILE_BINARY_ENABLE)
+/* index entries of a segment, a segment with a full index is rotated */
+#define INDEX_MAX_NUM (ELOG_FILE_MAX_SIZE / ELOG_FILE_INDEX_PERIOD + 1)
+#endif
+
+static elog_file_cfg_t cfg = {
+    .name          = ELOG_FILE_NAME,
+    .max_size      = ELOG_FILE_MAX_SIZE,
+    .max_rotate    = ELOG_FILE_MAX_ROTATE,
+    .rotate_period = ELOG_FILE_ROTATE_PERIOD,
+    .sync_period   = ELOG_FILE_SYNC_PERIOD,
+};
+
+static int      fd = -1;
+/* segment offset of the block, bytes in it and bytes of it already written */
+static size_t   block_offset;
+static size_t   block_used;
+static size_t   block_written;
+/* open time of the segment */
+static uint64_t segment_time;
+/* time of the oldest log that isn't on disk yet */
+static uint64_t dirty_time;
+/* logs were added or written since the last commit */
+static bool     dirty;
+
+static _Alignas(4096) char block[ELOG_FILE_BLOCK_SIZE];
+#if defined(ELOG_FILE_BINARY_ENABLE)
+static elog_seg_index_t    seg_index[INDEX_MAX_NUM];
+static size_t              seg_index_num;
+#else
+static char                line_buf[LINE_MAX_LEN];
+#endif
+
+static uint64_t now_ms (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void write_at (const char *data, size_t size, size_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t written = pwrite(fd, data, size, (off_t)offset);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            /* the logs are lost */
+            return;
+        }
+        data += written;
+        size -= (size_t)written;
+        offset += (size_t)written;
+    }
+}
+
+/* write the part of the block that wasn't written yet */
+static void block_flush (void)
+{
+    if (block_used > block_written)
+    {
+        write_at(block + block_written, block_used - block_written, block_offset + block_written);
+        block_written = block_used;
+    }
+}
+
+/* write a full block and go on with the next one */
+static void block_next (void)
+{
+    block_flush();
+    block_offset += sizeof(block);
+    block_used    = 0;
+    block_written = 0;
+}
+
+static void block_append (const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        size_t room = sizeof(block) - block_used;
+        size_t len  = (size < room) ? size : room;
+
+        memcpy(block + block_used, data, len);
+        block_used += len;
+        data += len;
+        size -= len;
+        if (block_used == sizeof(block))
+        {
+            block_next();
+        }
+    }
+}
+
+/* write everything and make it durable */
+static void commit (void)
+{
+    block_flush();
+    if (dirty)
+    {
+        fdatasync(fd);
+        dirty = false;
+    }
+}
+
+static void segment_name (char *name, size_t index)
+{
+    snprintf(name, NAME_MAX_LEN, "%s.%zu", cfg.name, index);
+}
+
+/* move the segment to .0 and the rotated ones one number up, the oldest one is dropped */
+static void segment_shift (void)
+{
+    char from[NAME_MAX_LEN], to[NAME_MAX_LEN];
+
+    if (cfg.max_rotate == 0)
+    {
+        unlink(cfg.name);
+        return;
+    }
+    for (size_t i = cfg.max_rotate - 1; i > 0; i--)
+    {
+        segment_name(from, i - 1);
+        segment_name(to, i);
+        rename(from, to);
+    }
+    segment_name(to, 0);
+    rename(cfg.name, to);
+}
+
+/* make the renames and the new segment durable */
+static void sync_dir (void)
+{
+    char        dir[NAME_MAX_LEN];
+    const char *slash = strrchr(cfg.name, '/');
+    int         dir_fd;
+
+    if (slash == NULL)
+    {
+        strcpy(dir, ".");
+    }
+    else
+    {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - cfg.name + 1), cfg.name);
+    }
+    dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0)
+    {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+/**
+ * open the segment and go on behind its content, the partial block at its end is read back
+ *
+ * @return result
+ */
+static ElogErrCode segment_open (void)
+{
+    off_t size;
+    int   flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+
+#if defined(ELOG_FILE_BINARY_ENABLE)
+    /* the segment was shifted, a segment left behind can't be continued */
+    flags |= O_TRUNC;
+#endif
+    fd = open(cfg.name, flags, 0644);
+    if (fd < 0)
+    {
+        return ELOG_INIT_FAIL;
+    }
+    size = lseek(fd, 0, SEEK_END);
+    if (size < 0)
+    {
+        size = 0;
+    }
+
+    block_offset  = (size_t)size / sizeof(block) * sizeof(block);
+    block_used    = (size_t)size - block_offset;
+    block_written = block_used;
+    if (block_used != 0)
+    {
+        int read_fd = open(cfg.name, O_RDONLY | O_CLOEXEC);
+        if (read_fd < 0 || pread(read_fd, block, block_used, (off_t)block_offset) != (ssize_t)block_used)
+        {
+            /* start a new block behind the content */
+            block_offset  = (size_t)size;
+            block_used    = 0;
+            block_written = 0;
+        }
+        if (read_fd >= 0)
+        {
+            close(read_fd);
+        }
+    }
+
+#if defined(__linux__)
+    /* allocate the whole segment at once, the file size stays at the content */
+    if ((size_t)size < cfg.max_size)
+    {
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, size, (off_t)(cfg.max_size - (size_t)size));
+    }
+#endif
+    segment_time = now_ms();
+
+#if defined(ELOG_FILE_BINARY_ENABLE)
+    elog_seg_head_t head = {.magic = ELOG_SEG_MAGIC, .version = ELOG_SEG_VERSION, .header_size = sizeof(elog_header_t)};
+
+    seg_index_num = 0;
+    block_append((const char *)&head, sizeof(head));
+#endif
+
+    return ELOG_NO_ERR;
+}
+
+#if defined(ELOG_FILE_BINARY_ENABLE)
+static uint64_t ts_ticks (elog_timestamp_t timestamp)
+{
+    return (uint64_t)timestamp.high << 32 | timestamp.low;
+}
+
+/* add a record to the index, a new entry starts ELOG_FILE_INDEX_PERIOD after the last one */
+static void index_add (const elog_header_t *header)
+{
+    size_t            offset = block_offset + block_used;
+    elog_seg_index_t *entry  = (seg_index_num != 0) ? &seg_index[seg_index_num - 1] : NULL;
+
+    if (entry == NULL || offset - entry->offset >= ELOG_FILE_INDEX_PERIOD)
+    {
+        elog_timestamp_t ts_max = header->timestamp;
+
+        if (entry != NULL && ts_ticks(entry->ts_max) > ts_ticks(ts_max))
+        {
+            ts_max = entry->ts_max;
+        }
+        entry = &seg_index[seg_index_num++];
+        memset(entry, 0, sizeof(elog_seg_index_t));
+        entry->offset  = (uint32_t)offset;
+        entry->seq_num = header->seq_num;
+        entry->ts_min  = header->timestamp;
+        entry->ts_max  = ts_max;
+    }
+    if (ts_ticks(header->timestamp) < ts_ticks(entry->ts_min))
+    {
+        entry->ts_min = header->timestamp;
+    }
+    if (ts_ticks(header->timestamp) > ts_ticks(entry->ts_max))
+    {
+        entry->ts_max = header->timestamp;
+    }
+    entry->count++;
+    if (header->level < ELOG_LVL_TOTAL_NUM)
+    {
+        entry->levels |= (uint8_t)ELOG_SEG_LVL(header->level);
+    }
+}
+
+static void append_zeros (size_t size)
+{
+    static const char zeros[8];
+
+    block_append(zeros, size);
+}
+
+static void append_string (const char *text)
+{
+    text = (text != NULL) ? text : "";
+    block_append(text, strlen(text) + 1);
+}
+
+/* append the index, the site table and the trailer behind the records */
+static void segment_footer (void)
+{
+    elog_seg_trailer_t trailer = {.magic = ELOG_SEG_TRAILER_MAGIC};
+    const elog_site_t *site;
+    uint32_t           offset;
+
+    trailer.records_end = (uint32_t)(block_offset + block_used);
+    append_zeros((8 - trailer.records_end % 8) % 8);
+    trailer.index_offset = (uint32_t)(block_offset + block_used);
+    trailer.index_num    = (uint32_t)seg_index_num;
+    block_append((const char *)seg_index, seg_index_num * sizeof(elog_seg_index_t));
+
+    trailer.site_offset = (uint32_t)(block_offset + block_used);
+    while (trailer.site_num < ELOG_SITE_ID_NONE && elog_find_site((uint16_t)trailer.site_num) != NULL)
+    {
+        trailer.site_num++;
+    }
+    offset = trailer.site_num * sizeof(uint32_t);
+    for (uint32_t i = 0; i < trailer.site_num; i++)
+    {
+        site = elog_find_site((uint16_t)i);
+        block_append((const char *)&offset, sizeof(offset));
+        offset += sizeof(uint32_t) + strlen(site->tag ? site->tag : "") + strlen(site->file ? site->file : "")
+                  + strlen(site->func ? site->func : "") + 3;
+    }
+    for (uint32_t i = 0; i < trailer.site_num; i++)
+    {
+        uint32_t line;
+
+        site = elog_find_site((uint16_t)i);
+        line = (uint32_t)site->line;
+        block_append((const char *)&line, sizeof(line));
+        append_string(site->tag);
+        append_string(site->file);
+        append_string(site->func);
+    }
+
+    append_zeros((4 - (block_offset + block_used) % 4) % 4);
+    block_append((const char *)&trailer, sizeof(trailer));
+}
+#endif /* ELOG_FILE_BINARY_ENABLE */
+
+/* commit and close the segment, the preallocated space behind the content is released */
+static void segment_close (void)
+{
+#if defined(ELOG_FILE_BINARY_ENABLE)
+    segment_footer();
+#endif
+    commit();
+    if (ftruncate(fd, (off_t)(block_offset + block_used)) == 0)
+    {
+        fdatasync(fd);
+    }
+    close(fd);
+    fd = -1;
+}
+
+/* close the segment and open a new one */
+static void segment_rotate (void)
+{
+    segment_close();
+    segment_shift();
+    segment_open();
+    sync_dir();
+}
+
+/* rotate when the segment is full or too old */
+static void rotate_check (uint64_t now)
+{
+    if (block_offset + block_used >= cfg.max_size
+#if defined(ELOG_FILE_BINARY_ENABLE)
+        || seg_index_num == INDEX_MAX_NUM
+#endif
+        || (cfg.rotate_period != 0 && now >= segment_time + cfg.rotate_period))
+    {
+        segment_rotate();
+    }
+}
+
+/**
+ * EasyLogger file sink initialize, the segment is opened
+ *
+ * @return result
+ */
+ElogErrCode elog_file_init (void)
+{
+    if (fd >= 0)
+    {
+        return ELOG_NO_ERR;
+    }
+#if defined(ELOG_FILE_BINARY_ENABLE)
+    if (access(cfg.name, F_OK) == 0)
+    {
+        segment_shift();
+    }
+#endif
+
+    return segment_open();
+}
+
+/**
+ * change the configuration, it takes effect with the next segment
+ *
+ * @param config configuration, the name must stay valid
+ */
+void elog_file_config (const elog_file_cfg_t *config)
+{
+    cfg = *config;
+}
+
+/**
+ * write a log to the file, see elog_file_write_batch
+ *
+ * @param log log, header and message
+ * @param size log size
+ */
+void elog_file_write (const char *log, size_t size)
+{
+    elog_span_t span = {log, size};
+
+    elog_file_write_batch(&span, 1);
+}
+
+/**
+ * render logs to the file, they are committed when ELOG_FILE_SYNC_PERIOD has passed since the oldest log
+ * that isn't on disk, or when one of them is at ELOG_FILE_SYNC_LVL or more severe
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+void elog_file_write_batch (const elog_span_t *logs, size_t count)
+{
+    bool     sync_now = false;
+    uint64_t now;
+
+    if (fd < 0 || count == 0)
+    {
+        return;
+    }
+
+    now = now_ms();
+    for (size_t i = 0; i < count; i++)
+    {
+        elog_header_t header;
+
+        rotate_check(now);
+        memcpy(&header, logs[i].data, sizeof(elog_header_t));
+        if (header.level <= ELOG_FILE_SYNC_LVL)
+        {
+            sync_now = true;
+        }
+
+#if defined(ELOG_FILE_BINARY_ENABLE)
+        index_add(&header);
+        block_append(logs[i].data, sizeof(elog_header_t) + header.message_length);
+#else
+        /* the line is rendered in place unless it may not fit in the rest of the block */
+        if (sizeof(block) - block_used >= LINE_MAX_LEN)
+        {
+            block_used += elog_render(logs[i].data, logs[i].size, block + block_used, LINE_MAX_LEN);
+            if (block_used == sizeof(block))
+            {
+                block_next();
+            }
+        }
+        else
+        {
+            size_t len = elog_render(logs[i].data, logs[i].size, line_buf, sizeof(line_buf));
+            block_append(line_buf, len);
+        }
+#endif /* ELOG_FILE_BINARY_ENABLE */
+    }
+
+    if (!dirty)
+    {
+        dirty      = true;
+        dirty_time = now;
+    }
+    if (sync_now || now - dirty_time >= cfg.sync_period)
+    {
+        commit();
+    }
+}
+
+/**
+ * commit the logs when ELOG_FILE_SYNC_PERIOD has passed and rotate an old segment, the drain calls it
+ * while there are no logs
+ */
+void elog_file_poll (void)
+{
+    uint64_t now;
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    now = now_ms();
+    if (dirty && now - dirty_time >= cfg.sync_period)
+    {
+        commit();
+    }
+    if (cfg.rotate_period != 0 && now >= segment_time + cfg.rotate_period && block_offset + block_used != 0)
+    {
+        segment_rotate();
+    }
+}
+
+/**
+ * commit the logs now
+ */
+void elog_file_flush (void)
+{
+    if (fd >= 0)
+    {
+        commit();
+    }
+}
+
+/**
+ * EasyLogger file sink deinitialize, the logs are committed and the segment is closed
+ */
+void elog_file_deinit (void)
+{
+    if (fd >= 0)
+    {
+        segment_close();
+    }
+}
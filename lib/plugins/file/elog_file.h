@@ -0,0 +1,59 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: File sink plugin, it writes the rendered logs in blocks to rotated segments.
+ * Created on: 2026-10-17
+ */
+
+#ifndef _ELOG_FILE_H_
+#define _ELOG_FILE_H_
+
+#include <elog.h>
+#include <elog_file_cfg.h>
+#include <stdint.h>
+
+/*
+ * The sink is fed by the asynchronous output drain (or by elog_port_output under the output lock),
+ * so it is never entered twice at once and producers never wait for the file.
+ */
+
+typedef struct
+{
+    const char *name;          /* file path, the rotated segments get .0, .1, ... appended */
+    size_t      max_size;      /* segment size that starts a new segment */
+    size_t      max_rotate;    /* rotated segments kept */
+    uint32_t    rotate_period; /* segment age that starts a new segment, in ms (0: never) */
+    uint32_t    sync_period;   /* longest time in ms a written log waits for fdatasync */
+} elog_file_cfg_t;
+
+/* elog_file.c */
+ElogErrCode elog_file_init (void);
+void        elog_file_config (const elog_file_cfg_t *cfg);
+void        elog_file_write (const char *log, size_t size);
+void        elog_file_write_batch (const elog_span_t *logs, size_t count);
+void        elog_file_poll (void);
+void        elog_file_flush (void);
+void        elog_file_deinit (void);
+
+#endif /* _ELOG_FILE_H_ */
@@ -0,0 +1,52 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Configuration of the file sink plugin.
+ * Created on: 2026-10-17
+ */
+
+#ifndef _ELOG_FILE_CFG_H_
+#define _ELOG_FILE_CFG_H_
+
+/* file the logs are written to, the rotated segments get .0, .1, ... appended, .0 is the newest */
+#define ELOG_FILE_NAME "elog.log"
+/* segment size that starts a new segment, it is preallocated when a segment is opened */
+#define ELOG_FILE_MAX_SIZE (10 * 1024 * 1024)
+/* rotated segments kept, 0: the segment is truncated instead */
+#define ELOG_FILE_MAX_ROTATE 5
+/* segment age that starts a new segment, in ms (0: never) */
+#define ELOG_FILE_ROTATE_PERIOD 0
+/* write block, only whole blocks are written at block aligned offsets until a commit */
+#define ELOG_FILE_BLOCK_SIZE (64 * 1024)
+/* longest time in ms a written log waits for fdatasync, the logs on the way are committed together */
+#define ELOG_FILE_SYNC_PERIOD 1000
+/* logs at this level or more severe are committed with the batch they came in */
+#define ELOG_FILE_SYNC_LVL ELOG_LVL_ERROR
+/* write the records as they are into indexed binary segments (elog_seg.h) instead of text lines,
+ * the segments must stay below 4 GiB */
+// #define ELOG_FILE_BINARY_ENABLE
+/* records between two index entries of a binary segment, in bytes */
+#define ELOG_FILE_INDEX_PERIOD 4096
+
+#endif /* _ELOG_FILE_CFG_H_ */
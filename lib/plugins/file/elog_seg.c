@@ -0,0 +1,355 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Reader of the indexed binary log segments, the seeks take O(log n) with a footer.
+ * Created on: 2026-10-17
+ */
+
+#include <elog_seg.h>
+#include <string.h>
+
+/*
+ * The segment image is read in place (a mapped file, a buffer). The index entries and headers are copied
+ * out with memcpy, so the image needs no alignment. A seek by time looks for the first block whose
+ * latest timestamp reaches the time, a seek by seq for the last block starting at or before the seq,
+ * both are binary searches over the index. The iterator skips whole blocks without a level of the filter
+ * and ends at the first block whose earliest timestamp is past the time range, the timestamps of the
+ * records follow their seq except for a small skew between the lanes.
+ */
+
+static uint64_t ts_ticks (elog_timestamp_t timestamp)
+{
+    return (uint64_t)timestamp.high << 32 | timestamp.low;
+}
+
+static elog_seg_index_t index_get (const elog_seg_t *seg, size_t i)
+{
+    elog_seg_index_t entry;
+
+    memcpy(&entry, seg->index + i * sizeof(elog_seg_index_t), sizeof(entry));
+    return entry;
+}
+
+/* offset behind a block */
+static size_t block_end (const elog_seg_t *seg, size_t i)
+{
+    return (i + 1 < seg->index_num) ? index_get(seg, i + 1).offset : seg->records_end;
+}
+
+/**
+ * read the header of the record at an offset
+ *
+ * @return record size, 0 at the end of the records or at a torn record
+ */
+static size_t record_get (const elog_seg_t *seg, size_t offset, elog_header_t *header)
+{
+    if (seg->records_end - offset < sizeof(elog_header_t))
+    {
+        return 0;
+    }
+    memcpy(header, seg->data + offset, sizeof(elog_header_t));
+    if (header->message_length > seg->records_end - offset - sizeof(elog_header_t))
+    {
+        return 0;
+    }
+
+    return sizeof(elog_header_t) + header->message_length;
+}
+
+/**
+ * open a segment image for reading, the footer is used when it is whole
+ *
+ * @param seg segment
+ * @param data segment image, it must stay valid while the segment is read
+ * @param size image size
+ *
+ * @return result, ELOG_INPUT_ERR when the image isn't a segment of a writer with the same header
+ */
+ElogErrCode elog_seg_open (elog_seg_t *seg, const char *data, size_t size)
+{
+    elog_seg_head_t    head;
+    elog_seg_trailer_t trailer;
+
+    memset(seg, 0, sizeof(elog_seg_t));
+    if (size < sizeof(head))
+    {
+        return ELOG_INPUT_ERR;
+    }
+    memcpy(&head, data, sizeof(head));
+    if (head.magic != ELOG_SEG_MAGIC || head.version != ELOG_SEG_VERSION || head.header_size != sizeof(elog_header_t))
+    {
+        return ELOG_INPUT_ERR;
+    }
+    seg->data        = data;
+    seg->size        = size;
+    seg->records_end = size;
+
+    if (size < sizeof(head) + sizeof(trailer))
+    {
+        return ELOG_NO_ERR;
+    }
+    memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    size -= sizeof(trailer);
+    if (trailer.magic != ELOG_SEG_TRAILER_MAGIC || trailer.records_end < sizeof(head)
+        || trailer.records_end > trailer.index_offset || trailer.index_offset > size
+        || trailer.index_num > (size - trailer.index_offset) / sizeof(elog_seg_index_t)
+        || trailer.site_offset < trailer.index_offset + trailer.index_num * sizeof(elog_seg_index_t)
+        || trailer.site_offset > size || trailer.site_num > (size - trailer.site_offset) / sizeof(uint32_t))
+    {
+        /* no footer, the writer didn't close the segment */
+        return ELOG_NO_ERR;
+    }
+    seg->records_end = trailer.records_end;
+    seg->index       = data + trailer.index_offset;
+    seg->index_num   = trailer.index_num;
+    seg->sites       = data + trailer.site_offset;
+    seg->site_num    = trailer.site_num;
+    seg->site_size   = size - trailer.site_offset;
+
+    return ELOG_NO_ERR;
+}
+
+/**
+ * start reading a segment at the first record the filter may take
+ *
+ * @param iter iterator
+ * @param seg segment
+ * @param filter filter, NULL: every record
+ */
+void elog_seg_iter_init (elog_seg_iter_t *iter, const elog_seg_t *seg, const elog_seg_filter_t *filter)
+{
+    iter->seg    = seg;
+    iter->offset = sizeof(elog_seg_head_t);
+    iter->entry  = 0;
+    if (filter != NULL)
+    {
+        iter->filter = *filter;
+        elog_seg_seek_time(iter, filter->time_begin);
+    }
+    else
+    {
+        iter->filter.time_begin = 0;
+        iter->filter.time_end   = UINT64_MAX;
+        iter->filter.levels     = ELOG_SEG_LVL_ALL;
+    }
+}
+
+/**
+ * go to the first block that may hold a record at or after a time, the filter still applies
+ * Without a footer the iterator goes back to the first record.
+ *
+ * @param iter iterator
+ * @param time timestamp ticks
+ */
+void elog_seg_seek_time (elog_seg_iter_t *iter, uint64_t time)
+{
+    const elog_seg_t *seg  = iter->seg;
+    size_t            low  = 0;
+    size_t            high = seg->index_num;
+
+    iter->offset = sizeof(elog_seg_head_t);
+    iter->entry  = 0;
+    if (seg->index == NULL)
+    {
+        return;
+    }
+
+    /* first block whose latest timestamp reaches the time */
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (ts_ticks(index_get(seg, mid).ts_max) < time)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    iter->entry  = low;
+    iter->offset = (low < seg->index_num) ? index_get(seg, low).offset : seg->records_end;
+}
+
+/**
+ * go to the first record at or after a seq, the filter still applies
+ * The seqs of a segment must not wrap around, a seq before the segment goes to its first record.
+ *
+ * @param iter iterator
+ * @param seq_num sequence number
+ */
+void elog_seg_seek_seq (elog_seg_iter_t *iter, uint32_t seq_num)
+{
+    const elog_seg_t *seg  = iter->seg;
+    size_t            low  = 0;
+    size_t            high = seg->index_num;
+    size_t            offset, end;
+    elog_header_t     header;
+
+    iter->offset = sizeof(elog_seg_head_t);
+    iter->entry  = 0;
+    if (seg->index != NULL)
+    {
+        /* last block starting at or before the seq */
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+
+            if ((int32_t)(index_get(seg, mid).seq_num - seq_num) <= 0)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        if (low == 0)
+        {
+            return;
+        }
+        iter->entry  = low - 1;
+        iter->offset = index_get(seg, low - 1).offset;
+    }
+
+    end = (seg->index != NULL) ? block_end(seg, iter->entry) : seg->records_end;
+    for (offset = iter->offset; offset < end;)
+    {
+        size_t size = record_get(seg, offset, &header);
+
+        if (size == 0 || (int32_t)(header.seq_num - seq_num) >= 0)
+        {
+            break;
+        }
+        offset += size;
+    }
+    iter->offset = offset;
+}
+
+/**
+ * read the next record the filter takes
+ *
+ * @param iter iterator
+ * @param record record, header and message, in the segment image
+ *
+ * @return false at the end of the records
+ */
+bool elog_seg_next (elog_seg_iter_t *iter, elog_span_t *record)
+{
+    const elog_seg_t        *seg    = iter->seg;
+    const elog_seg_filter_t *filter = &iter->filter;
+    elog_header_t            header;
+
+    while (iter->offset < seg->records_end)
+    {
+        if (seg->index_num != 0)
+        {
+            while (iter->entry + 1 < seg->index_num && index_get(seg, iter->entry + 1).offset <= iter->offset)
+            {
+                iter->entry++;
+            }
+
+            elog_seg_index_t entry = index_get(seg, iter->entry);
+            if (entry.offset == iter->offset)
+            {
+                if (ts_ticks(entry.ts_min) > filter->time_end)
+                {
+                    iter->offset = seg->records_end;
+                    return false;
+                }
+                if (!(entry.levels & filter->levels) || ts_ticks(entry.ts_max) < filter->time_begin)
+                {
+                    iter->offset = block_end(seg, iter->entry);
+                    continue;
+                }
+            }
+        }
+
+        size_t size = record_get(seg, iter->offset, &header);
+        if (size == 0)
+        {
+            /* torn record */
+            iter->offset = seg->records_end;
+            return false;
+        }
+        record->data = seg->data + iter->offset;
+        record->size = size;
+        iter->offset += size;
+
+        uint64_t time = ts_ticks(header.timestamp);
+        if (header.level < ELOG_LVL_TOTAL_NUM && (filter->levels & ELOG_SEG_LVL(header.level))
+            && (filter->blocks || (time >= filter->time_begin && time <= filter->time_end)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * find a call site in the site table of the segment
+ *
+ * @param seg segment
+ * @param site_id call-site id of a record header
+ * @param site call site, the strings are in the segment image
+ *
+ * @return false when the segment has no such site
+ */
+bool elog_seg_find_site (const elog_seg_t *seg, uint16_t site_id, elog_seg_site_t *site)
+{
+    const char *strings[3];
+    uint32_t    offset, line;
+
+    if (seg->sites == NULL || site_id >= seg->site_num)
+    {
+        return false;
+    }
+    memcpy(&offset, seg->sites + site_id * sizeof(uint32_t), sizeof(offset));
+    if (offset == 0 || offset > seg->site_size - sizeof(line))
+    {
+        return false;
+    }
+    memcpy(&line, seg->sites + offset, sizeof(line));
+    offset += sizeof(line);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        const char *end = memchr(seg->sites + offset, '\0', seg->site_size - offset);
+
+        if (end == NULL)
+        {
+            return false;
+        }
+        strings[i] = seg->sites + offset;
+        offset     = (uint32_t)(end + 1 - seg->sites);
+    }
+    site->tag  = strings[0];
+    site->file = strings[1];
+    site->func = strings[2];
+    site->line = (long)line;
+
+    return true;
+}
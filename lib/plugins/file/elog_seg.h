@@ -0,0 +1,134 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Indexed binary log segments: the layout and a reader that seeks by seq, time and level.
+ * Created on: 2026-10-17
+ */
+
+#ifndef _ELOG_SEG_H_
+#define _ELOG_SEG_H_
+
+#include <elog.h>
+#include <stdint.h>
+
+/*
+ * A segment keeps the drained records as they are, header and message, behind a segment head. A closed
+ * segment ends with a footer: a sparse index with an entry per block of a few KiB of records,
+ * the call-site table (tag, file, function and line of every site id) and a fixed size trailer, which is
+ * found at the end of the file. Everything is in the byte order of the writer.
+ *
+ *   | head | record | record | ... | pad to 8 | index entries | site offsets | site strings | pad to 4 | trailer |
+ *
+ * A segment without a footer (the writer crashed) is still read, the seeks scan it from the start then
+ * and a torn record at its end is dropped.
+ */
+
+#define ELOG_SEG_MAGIC         0x47534C45 /* "ELSG" */
+#define ELOG_SEG_TRAILER_MAGIC 0x58444E49 /* "INDX" */
+#define ELOG_SEG_VERSION       1
+
+/* level bits of elog_seg_filter_t.levels and elog_seg_index_t.levels */
+#define ELOG_SEG_LVL(level)    (1u << (level))
+#define ELOG_SEG_LVL_ALL       ((1u << ELOG_LVL_TOTAL_NUM) - 1)
+
+/* segment head, at offset 0 */
+typedef struct
+{
+    uint32_t magic;       /* ELOG_SEG_MAGIC */
+    uint16_t version;     /* ELOG_SEG_VERSION */
+    uint16_t header_size; /* sizeof(elog_header_t) of the writer, the reader must match it */
+} elog_seg_head_t;
+
+/* index entry of a block of records, the blocks start at records */
+typedef struct
+{
+    uint32_t         offset;  /* first record of the block */
+    uint32_t         seq_num; /* of the first record */
+    elog_timestamp_t ts_min;  /* earliest timestamp of the block */
+    elog_timestamp_t ts_max;  /* latest timestamp up to the end of the block, it never decreases */
+    uint32_t         count;   /* records of the block */
+    uint8_t          levels;  /* ELOG_SEG_LVL of every level in the block */
+    uint8_t          reserved[3];
+} elog_seg_index_t;
+
+/* site offsets: offset of the strings of each site id from the site table start, 0: unknown site
+ * site strings: line as uint32_t, then tag, file and function, each with a terminating zero */
+typedef struct
+{
+    uint32_t index_offset; /* first index entry */
+    uint32_t index_num;
+    uint32_t site_offset;  /* site offsets, the strings follow them */
+    uint32_t site_num;
+    uint32_t records_end;  /* end of the last record */
+    uint32_t magic;        /* ELOG_SEG_TRAILER_MAGIC */
+} elog_seg_trailer_t;
+
+/* segment opened for reading, it refers to the segment image */
+typedef struct
+{
+    const char *data;
+    size_t      size;
+    size_t      records_end;
+    const char *index;     /* NULL without a footer */
+    size_t      index_num;
+    const char *sites;     /* NULL without a footer */
+    size_t      site_num;
+    size_t      site_size; /* site offsets and strings */
+} elog_seg_t;
+
+/* records returned by elog_seg_next, the time range is in timestamp ticks and includes its ends */
+typedef struct
+{
+    uint64_t time_begin;
+    uint64_t time_end;
+    uint32_t levels; /* ELOG_SEG_LVL of the levels to return */
+    bool     blocks; /* the time range only picks the blocks, every record of them is returned */
+} elog_seg_filter_t;
+
+typedef struct
+{
+    const elog_seg_t *seg;
+    elog_seg_filter_t filter;
+    size_t            offset; /* next record */
+    size_t            entry;  /* index entry of the next record */
+} elog_seg_iter_t;
+
+/* call site of a record from the site table */
+typedef struct
+{
+    const char *tag;
+    const char *file;
+    const char *func;
+    long        line;
+} elog_seg_site_t;
+
+/* elog_seg.c */
+ElogErrCode elog_seg_open (elog_seg_t *seg, const char *data, size_t size);
+void        elog_seg_iter_init (elog_seg_iter_t *iter, const elog_seg_t *seg, const elog_seg_filter_t *filter);
+void        elog_seg_seek_seq (elog_seg_iter_t *iter, uint32_t seq_num);
+void        elog_seg_seek_time (elog_seg_iter_t *iter, uint64_t time);
+bool        elog_seg_next (elog_seg_iter_t *iter, elog_span_t *record);
+bool        elog_seg_find_site (const elog_seg_t *seg, uint16_t site_id, elog_seg_site_t *site);
+
+#endif /* _ELOG_SEG_H_ */
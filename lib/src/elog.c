@@ -27,24 +27,85 @@
  */
 
 #define LOG_TAG            "elog"
-#define ELOG_LINE_BUF_SIZE 1024
 
 #include <elog.h>
+#include <elog_stats.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 #if !defined(ELOG_NEWLINE_SIGN)
     #error "Please configure output newline sign (in elog_cfg.h)"
 #endif
 
+#if defined(ELOG_DEFERRED_FMT_ENABLE) && !defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    #error "Deferred formatting is rendered on the asynchronous drain, please enable ELOG_ASYNC_OUTPUT_ENABLE"
+#endif
+
+#if defined(ELOG_HEXDUMP_ENABLE) && ELOG_LINE_BUF_SIZE < 32 + 14 + ELOG_HEXDUMP_WIDTH * 4
+    #error "ELOG_LINE_BUF_SIZE must hold a hexdump line"
+#endif
+
+#if defined(ELOG_ASYNC_ZERO_COPY_ENABLE) && !defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    #error "Zero-copy output formats into the asynchronous ring buffer, please enable ELOG_ASYNC_OUTPUT_ENABLE"
+#endif
+
 /* EasyLogger object */
 static EasyLogger elog;
-/* every line log's buffer */
-static char line_log_buf[ELOG_LINE_BUF_SIZE] = {0};
+/* every line log's buffer for interrupt context */
+static char isr_line_log_buf[ELOG_LINE_BUF_SIZE] = {0};
+#if defined(ELOG_LINE_BUF_THREAD_LOCAL)
+/* every line log's buffer for task context, one per thread */
+static _Thread_local char line_log_buf[ELOG_LINE_BUF_SIZE];
+#elif !defined(ELOG_LINE_BUF_ON_STACK)
+/* every line log's buffer for task context, it is shared, so the logs are formatted under the output lock */
+static char line_log_buf[ELOG_LINE_BUF_SIZE];
+    #define LINE_BUF_SHARED
+#endif
+/* call-site descriptors emitted by the log macros, weak because all of them may be compiled out */
+extern const elog_site_t __start_elog_sites[] __attribute__((weak));
+extern const elog_site_t __stop_elog_sites[] __attribute__((weak));
+#if defined(ELOG_PRINTF_ENABLE)
+extern int elog_vsnprintf(char *buf, size_t size, const char *format, va_list args);
+extern int elog_snprintf(char *buf, size_t size, const char *format, ...);
+    #define line_vsnprintf elog_vsnprintf
+    #define line_snprintf  elog_snprintf
+#else
+    #define line_vsnprintf vsnprintf
+    #define line_snprintf  snprintf
+#endif /* ELOG_PRINTF_ENABLE */
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+extern elog_timestamp_t elog_port_get_counter(void);
+    /* records are stamped with the cycle counter, output_calib pairs it with the wall time */
+    #define record_time elog_port_get_counter
+#else
+    #define record_time elog_port_get_time
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+
 /* The sequence number of the message */
-static uint32_t g_seq_num = 0;
+static _Atomic uint32_t g_seq_num = 0;
+/* gap marker text in front of the number of dropped logs */
+#define GAP_PREFIX "dropped "
+/* logs dropped since the last gap marker */
+static _Atomic uint32_t g_drop_pending = 0;
+/* logs dropped since the start */
+static _Atomic uint32_t g_drop_count = 0;
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)                                                                            \
+    && (ELOG_ASYNC_ISR_BUF_SIZE > 0 || (defined(ELOG_ASYNC_HIGH_BUF_SIZE) && ELOG_ASYNC_HIGH_BUF_SIZE > 0))
+/* the drain merges the lanes up to the lowest sequence number a producer may still publish */
+    #define SEQ_IN_FLIGHT
+    /* in-flight slots: the output lock holders of task and interrupt context, then the ISR lane interrupts */
+    #define IN_FLIGHT_LOCK_SLOT(is_isr) ((is_isr) ? 1 : 0)
+    #define IN_FLIGHT_NUM               (2 + ((ELOG_ASYNC_ISR_BUF_SIZE > 0) ? ELOG_ASYNC_ISR_NEST_MAX : 0))
+/* a slot is taken before its producer takes a sequence number and given back after the record is published,
+ * it holds a sequence number at or below the one taken */
+static atomic_bool      g_in_flight_busy[IN_FLIGHT_NUM];
+static _Atomic uint32_t g_in_flight_seq[IN_FLIGHT_NUM];
+#endif /* SEQ_IN_FLIGHT */
 /* level output info */
 const char *level_output_info[] = {
     [ELOG_LVL_ASSERT]  = "[Assert]",
@@ -78,6 +139,15 @@ ElogErrCode elog_init (void)
         return result;
     }
 
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+    /* the lanes must be in place before the port starts draining them */
+    result = elog_async_init();
+    if (result != ELOG_NO_ERR)
+    {
+        return result;
+    }
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
     /* port initialize */
     result = elog_port_init();
     if (result != ELOG_NO_ERR)
@@ -85,6 +155,12 @@ ElogErrCode elog_init (void)
         return result;
     }
 
+    /* every level starts with the default format */
+    for (uint8_t level = 0; level < ELOG_LVL_TOTAL_NUM; level++)
+    {
+        elog_set_fmt(level, ELOG_FMT_DEFAULT);
+    }
+
     /* enable the output lock */
     elog_output_lock_enabled(true);
     /* output locked status initialize */
@@ -131,8 +207,17 @@ void elog_start (void)
 
     elog_async_enabled(true);
 
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+    extern size_t elog_async_recovered(void);
+    /* the recovered logs are drained in front of it */
+    if (elog_async_recovered() != 0)
+    {
+        elog_w(LOG_TAG, "%lu logs of the previous boot recovered.", (unsigned long)elog_async_recovered());
+    }
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
     /* show version */
-    elog_i("EasyLogger V%s is initialize success.", ELOG_SW_VERSION);
+    elog_i(LOG_TAG, "EasyLogger V%s is initialize success.", ELOG_SW_VERSION);
 }
 
 /**
@@ -151,7 +236,7 @@ void elog_stop (void)
     elog_async_enabled(false);
 
     /* show version */
-    elog_i("EasyLogger V%s is deinitialize success.", ELOG_SW_VERSION);
+    elog_i(LOG_TAG, "EasyLogger V%s is deinitialize success.", ELOG_SW_VERSION);
 }
 
 /**
@@ -174,6 +259,25 @@ bool elog_get_output_enabled (void)
     return elog.output_enabled;
 }
 
+/**
+ * set the prefix fields of a level for elog_render
+ *
+ * @param level level
+ * @param set format set, ElogFmtIndex bits
+ */
+void elog_set_fmt (uint8_t level, size_t set)
+{
+    extern void elog_render_set_fmt(uint8_t level, size_t set);
+
+    if (level >= ELOG_LVL_TOTAL_NUM)
+    {
+        return;
+    }
+
+    elog.enabled_fmt_set[level] = set;
+    elog_render_set_fmt(level, set);
+}
+
 /**
  * lock output
  */
@@ -182,14 +286,17 @@ bool elog_output_lock (bool is_isr)
     if (elog.output_lock_enabled)
     {
         elog.output_is_locked_before_disable = true;
-        if (is_isr)
-        {
-            return elog_port_output_lock_isr();
-        }
-        else
+        if (!(is_isr ? elog_port_output_lock_isr() : elog_port_output_lock()))
         {
-            return elog_port_output_lock();
+            return false;
         }
+#if defined(SEQ_IN_FLIGHT)
+        /* the lock holder is the only one on its slot */
+        atomic_store_explicit(&g_in_flight_seq[IN_FLIGHT_LOCK_SLOT(is_isr)],
+                              atomic_load_explicit(&g_seq_num, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&g_in_flight_busy[IN_FLIGHT_LOCK_SLOT(is_isr)], true, memory_order_relaxed);
+#endif /* SEQ_IN_FLIGHT */
+        return true;
     }
     else
     {
@@ -206,6 +313,10 @@ bool elog_output_unlock (bool is_isr)
     if (elog.output_lock_enabled)
     {
         elog.output_is_locked_before_disable = false;
+#if defined(SEQ_IN_FLIGHT)
+        /* the records of the lock holder are published */
+        atomic_store_explicit(&g_in_flight_busy[IN_FLIGHT_LOCK_SLOT(is_isr)], false, memory_order_release);
+#endif /* SEQ_IN_FLIGHT */
         if (is_isr)
         {
             return elog_port_output_unlock_isr();
@@ -223,101 +334,953 @@ bool elog_output_unlock (bool is_isr)
 }
 
 /**
- * output the log
+ * make sure the message ends with a newline sign, the newline replaces the message tail when there is no room
  *
- * @param level level
- * @param tag tag
- * @param file file name
- * @param func function name
- * @param line line number
+ * @param message message buffer
+ * @param log_len current message length
+ * @param max_len message buffer capacity
+ *
+ * @return message length including the newline sign
+ */
+size_t elog_line_terminate (char *message, size_t log_len, size_t max_len)
+{
+    size_t newline_len = strlen(ELOG_NEWLINE_SIGN);
+
+    // If last character is not a newline, add one
+    if ((log_len < newline_len) || (memcmp(message + log_len - newline_len, ELOG_NEWLINE_SIGN, newline_len) != 0))
+    {
+        if (log_len + newline_len > max_len)
+        {
+            log_len = max_len - newline_len;
+        }
+        memcpy(message + log_len, ELOG_NEWLINE_SIGN, newline_len);
+        log_len += newline_len;
+    }
+
+    return log_len;
+}
+
+/**
+ * format the log message behind the header space of the line buffer, it always ends with a newline sign
+ *
+ * @param buf line buffer
+ * @param size line buffer size
+ * @param type record type of the formatted message
+ * @param truncated the message was longer than the line buffer
  * @param format output format
- * @param ... args
+ * @param args args
  *
+ * @return message length, -1 when the format failed
  */
-void elog_output (bool is_isr, uint8_t level, const char *tag, const char *file, const char *func, const long line,
-                  const char *format, ...)
+static int format_line_log (char *buf, size_t size, uint8_t *type, bool *truncated, const char *format,
+                            va_list args)
+{
+    char  *message = buf + sizeof(elog_header_t);
+    size_t max_len = size - sizeof(elog_header_t) - 1;
+
+#if defined(ELOG_DEFERRED_FMT_ENABLE)
+    extern int elog_deferred_pack(char *payload, size_t size, const char *format, va_list args);
+
+    /* only pack the format pointer and raw args, the drain side renders the text */
+    va_list pack_args;
+    va_copy(pack_args, args);
+    int pack_result = elog_deferred_pack(message, max_len, format, pack_args);
+    va_end(pack_args);
+
+    if (pack_result >= 0)
+    {
+        *type      = ELOG_RECORD_DEFERRED;
+        *truncated = false;
+        return pack_result;
+    }
+    /* the raw args don't fit, fall back to formatting the text now */
+#endif /* ELOG_DEFERRED_FMT_ENABLE */
+
+    int fmt_result = line_vsnprintf(message, max_len + 1, format, args);
+    if (fmt_result < 0)
+    {
+        return -1;
+    }
+
+    size_t log_len = ((size_t)fmt_result > max_len) ? max_len : (size_t)fmt_result;
+
+    *type      = ELOG_RECORD_TEXT;
+    *truncated = (size_t)fmt_result > max_len;
+    return (int)elog_line_terminate(message, log_len, max_len);
+}
+
+/**
+ * count dropped logs, the next log that gets out is preceded by a gap marker
+ *
+ * @param count number of dropped logs
+ */
+void elog_count_drops (uint32_t count)
+{
+    atomic_fetch_add_explicit(&g_drop_pending, count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_drop_count, count, memory_order_relaxed);
+}
+
+/**
+ * count a log evicted from the full ring buffer, it must be called with the output lock held
+ * The logs an evicted gap marker stood for are pending again, they go into the next marker.
+ *
+ * @param header evicted record header
+ * @param message evicted record message
+ */
+void elog_count_evicted (const elog_header_t *header, const char *message)
+{
+    if (header->type == ELOG_RECORD_GAP)
+    {
+        uint32_t dropped;
+        memcpy(&dropped, message, sizeof(dropped));
+        atomic_fetch_add_explicit(&g_drop_pending, dropped, memory_order_relaxed);
+    }
+    else
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+    }
+}
+
+/**
+ * get the number of logs dropped since the start, because the output lock was taken or the
+ * asynchronous output ring buffer was full
+ *
+ * @return number of dropped logs
+ */
+uint32_t elog_get_drop_count (void)
+{
+    return atomic_load_explicit(&g_drop_count, memory_order_relaxed);
+}
+
+/**
+ * set the sequence number of the next log, the logs recovered from the previous boot come before it
+ * It must not be set back while there are logs in the lanes, the drain would hold them back.
+ *
+ * @param seq_num next sequence number
+ */
+void elog_set_seq_num (uint32_t seq_num)
+{
+    atomic_store_explicit(&g_seq_num, seq_num, memory_order_release);
+}
+
+/**
+ * get the merge bound of the drain, every record with a lower sequence number is published and visible
+ * after the call. It is the sequence number of the next log, or the lowest one a producer has taken and
+ * not published yet.
+ *
+ * @return merge bound
+ */
+uint32_t elog_next_seq_num (void)
+{
+    uint32_t bound = atomic_load_explicit(&g_seq_num, memory_order_acquire);
+
+#if defined(SEQ_IN_FLIGHT)
+    /* a producer that took a number below the bound took its slot before */
+    for (size_t i = 0; i < IN_FLIGHT_NUM; i++)
+    {
+        if (atomic_load_explicit(&g_in_flight_busy[i], memory_order_acquire))
+        {
+            uint32_t seq_num = atomic_load_explicit(&g_in_flight_seq[i], memory_order_relaxed);
+
+            if ((int32_t)(seq_num - bound) < 0)
+            {
+                bound = seq_num;
+            }
+        }
+    }
+#endif /* SEQ_IN_FLIGHT */
+
+    return bound;
+}
+
+/**
+ * render a gap marker payload, the number of dropped logs, to its text
+ *
+ * @param payload gap marker payload
+ * @param len payload length
+ * @param out text buffer
+ * @param size text buffer size
+ *
+ * @return text length, it ends with a newline sign
+ */
+size_t elog_gap_render (const char *payload, size_t len, char *out, size_t size)
+{
+    uint32_t dropped = 0;
+    int      text_len;
+
+    if (len >= sizeof(dropped))
+    {
+        memcpy(&dropped, payload, sizeof(dropped));
+    }
+    text_len = line_snprintf(out, size, GAP_PREFIX "%lu logs", (unsigned long)dropped);
+    if (text_len < 0)
+    {
+        text_len = 0;
+    }
+    else if ((size_t)text_len >= size)
+    {
+        text_len = (int)size - 1;
+    }
+    return elog_line_terminate(out, (size_t)text_len, size - 1);
+}
+
+/**
+ * output a gap marker for the logs dropped since the last one, it must be called with the output lock held
+ * Its payload is the number of dropped logs, the drain renders the text.
+ *
+ * @param is_isr called from interrupt context
+ * @param level level of the log that follows, the marker may use the ring buffer space reserved for it
+ *
+ * @return false when the marker was dropped, the drops stay pending then and the log that follows is
+ *         dropped with the sequence number the marker took
+ */
+static bool output_gap (bool is_isr, uint8_t level)
 {
     extern elog_timestamp_t elog_port_get_time(void);
 
-    /* check output enabled */
-    if (!elog.output_enabled)
+    _Alignas(elog_header_t) char record[sizeof(elog_header_t) + 48];
+    elog_header_t header = {0};
+    uint32_t      dropped;
+
+    if (atomic_load_explicit(&g_drop_pending, memory_order_relaxed) == 0)
+    {
+        return true;
+    }
+    /* interrupts on the ISR lane may output markers concurrently, every drop is taken by one of them */
+    dropped = atomic_exchange_explicit(&g_drop_pending, 0, memory_order_relaxed);
+    if (dropped == 0)
+    {
+        return true;
+    }
+
+    /* the marker is a record of its own, the gap in front of it is as long as the number it carries */
+    header.seq_num        = atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+    header.level          = ELOG_LVL_WARN;
+    header.type           = ELOG_RECORD_GAP;
+    header.site_id        = ELOG_SITE_ID_NONE;
+    header.timestamp      = record_time();
+    header.message_length = sizeof(dropped);
+    memcpy(record + sizeof(elog_header_t), &dropped, sizeof(dropped));
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    extern bool elog_async_output(bool is_isr, uint8_t level, const char *log, size_t size);
+    memcpy(record, &header, sizeof(elog_header_t));
+    if (!elog_async_output(is_isr, level, record, header.message_length + sizeof(elog_header_t)))
+    {
+        atomic_fetch_add_explicit(&g_drop_pending, dropped, memory_order_relaxed);
+        return false;
+    }
+#else
+    (void)is_isr;
+    (void)level;
+    /* no drain renders it, the port gets the text */
+    header.message_length = elog_gap_render(record + sizeof(elog_header_t), sizeof(dropped),
+                                            record + sizeof(elog_header_t), sizeof(record) - sizeof(elog_header_t));
+    memcpy(record, &header, sizeof(elog_header_t));
+    elog_port_output(record, header.message_length + sizeof(elog_header_t));
+#endif
+
+    return true;
+}
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/* counter of the last calibration record, only touched with the output lock held */
+static uint64_t calib_counter;
+static bool     calib_done = false;
+
+/**
+ * output a calibration record once ELOG_TIME_CALIB_PERIOD has passed since the last one, it must be called
+ * with the output lock held
+ * It pairs the counter with elog_port_get_time, so the clock is only read once per period. The record takes
+ * a sequence number of its own, one that doesn't fit is counted as dropped and tried again with the next
+ * log. The ISR lane has no lock and doesn't output them.
+ *
+ * @param is_isr called from interrupt context
+ * @param level level of the log that follows, the record goes to its lane
+ * @param counter counter the log that follows is stamped with
+ */
+static void output_calib (bool is_isr, uint8_t level, elog_timestamp_t counter)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+
+    _Alignas(elog_header_t) char record[sizeof(elog_header_t) + sizeof(elog_timestamp_t)];
+    elog_header_t    header = {0};
+    uint64_t         ticks  = (uint64_t)counter.high << 32 | counter.low;
+    elog_timestamp_t time;
+
+    if (calib_done && ticks - calib_counter < ELOG_TIME_CALIB_PERIOD)
     {
         return;
     }
 
-    // Create header for current log
+    time                  = elog_port_get_time();
+    header.seq_num        = atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+    header.level          = level;
+    header.type           = ELOG_RECORD_CALIB;
+    header.site_id        = ELOG_SITE_ID_NONE;
+    header.timestamp      = counter;
+    header.message_length = sizeof(time);
+    memcpy(record, &header, sizeof(elog_header_t));
+    memcpy(record + sizeof(elog_header_t), &time, sizeof(time));
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    extern bool elog_async_output(bool is_isr, uint8_t level, const char *log, size_t size);
+    if (!elog_async_output(is_isr, level, record, sizeof(record)))
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        return;
+    }
+#else
+    (void)is_isr;
+    elog_port_output(record, sizeof(record));
+#endif
+    calib_counter = ticks;
+    calib_done    = true;
+}
+#else
+    #define output_calib(is_isr, level, counter)
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE) && ELOG_ASYNC_ISR_BUF_SIZE > 0
+/**
+ * take an in-flight slot of the ISR lane, before the interrupt takes a sequence number
+ *
+ * @return slot, IN_FLIGHT_NUM when ELOG_ASYNC_ISR_NEST_MAX interrupts hold one
+ */
+static size_t in_flight_take (void)
+{
+    for (size_t i = IN_FLIGHT_LOCK_SLOT(true) + 1; i < IN_FLIGHT_NUM; i++)
+    {
+        bool busy = false;
+
+        if (atomic_compare_exchange_strong_explicit(&g_in_flight_busy[i], &busy, true, memory_order_relaxed,
+                                                    memory_order_relaxed))
+        {
+            /* the sequence number taken after it is published with it */
+            atomic_store_explicit(&g_in_flight_seq[i], atomic_load_explicit(&g_seq_num, memory_order_relaxed),
+                                  memory_order_relaxed);
+            return i;
+        }
+    }
+    return IN_FLIGHT_NUM;
+}
+
+/**
+ * give an in-flight slot of the ISR lane back, after the records of the interrupt are published
+ *
+ * @param slot in-flight slot
+ */
+static void in_flight_give (size_t slot)
+{
+    atomic_store_explicit(&g_in_flight_busy[slot], false, memory_order_release);
+}
+
+/**
+ * output the log of interrupt context to the ISR lane, without taking the output lock
+ * The message is formatted on the interrupt stack, so it is cut to ELOG_ASYNC_ISR_LINE_BUF_SIZE.
+ *
+ * @param site call-site descriptor
+ * @param format output format
+ * @param args args
+ */
+static void output_log_isr (const elog_site_t *site, const char *format, va_list args)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+    extern bool             elog_async_output(bool is_isr, uint8_t level, const char *log, size_t size);
+
+    _Alignas(elog_header_t) char log_buf[ELOG_ASYNC_ISR_LINE_BUF_SIZE];
     elog_header_t log_header = {0};
+    uint8_t       type       = ELOG_RECORD_TEXT;
+    bool          truncated  = false;
+    bool          published;
+    size_t        slot;
+    int           log_len    = format_line_log(log_buf, sizeof(log_buf), &type, &truncated, format, args);
 
-    /* args point to the first variable parameter */
-    va_list args;
-    va_start(args, format);
-    bool is_success = elog_output_lock(is_isr);
-    if (!is_success)
+    if (log_len < 0)
     {
-        // If we fail to get the lock, increase the sequence number to indicate a skipped log message
-        g_seq_num++;
+        return;
+    }
+    slot = in_flight_take();
+    if (slot == IN_FLIGHT_NUM)
+    {
+        /* too many interrupts on the lane, like a taken output lock */
+        atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+        ELOG_STATS_ADD(lock_fails, 1);
+        elog_count_drops(1);
+        return;
+    }
+    if (!output_gap(true, site->level))
+    {
+        in_flight_give(slot);
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
         return;
     }
 
-    // Add sequence number to the log line
-    log_header.seq_num = g_seq_num++;
+    log_header.seq_num        = atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+    log_header.level          = site->level;
+    log_header.type           = type;
+    log_header.site_id        = elog_site_id(site);
+    log_header.timestamp      = record_time();
+    log_header.message_length = log_len;
+    memcpy(log_buf, &log_header, sizeof(elog_header_t));
 
-    log_header.level = level;
+    published = elog_async_output(true, site->level, log_buf, log_header.message_length + sizeof(elog_header_t));
+    in_flight_give(slot);
+    if (!published)
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        return;
+    }
+    ELOG_STATS_ADD(records, 1);
+    ELOG_STATS_ADD(bytes, log_header.message_length + sizeof(elog_header_t));
+    if (truncated)
+    {
+        ELOG_STATS_ADD(truncations, 1);
+    }
+}
+#endif /* defined(ELOG_ASYNC_OUTPUT_ENABLE) && ELOG_ASYNC_ISR_BUF_SIZE > 0 */
 
-    log_header.timestamp = elog_port_get_time();
+/**
+ * output the log, elog_output does the checks before it
+ *
+ * With ELOG_LINE_BUF_THREAD_LOCAL or ELOG_LINE_BUF_ON_STACK the message is formatted before the output
+ * lock is taken, so concurrent callers only serialize on the sequence number, the timestamp and the output
+ * itself, otherwise it is formatted under the lock into the shared line buffer. Interrupt context formats
+ * into a shared static buffer while holding the ISR lock, unless it has its own lane (ELOG_ASYNC_ISR_BUF_SIZE).
+ * With ELOG_ASYNC_ZERO_COPY_ENABLE the message is formatted under the lock straight into a reserved
+ * ring buffer slot, which saves the copy into the ring.
+ *
+ * @param is_isr called from interrupt context
+ * @param site call-site descriptor, it carries the level, tag, file, function and line
+ * @param format output format
+ * @param args args
+ */
+static void output_log (bool is_isr, const elog_site_t *site, const char *format, va_list args)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
 
-    /* skip the space for header and package other log data to buffer.*/
-    size_t header_size = sizeof(elog_header_t);
-    int    fmt_result  = vsnprintf(line_log_buf + header_size, ELOG_LINE_BUF_SIZE - header_size, format, args);
+#if defined(ELOG_LINE_BUF_ON_STACK) && !defined(ELOG_LINE_BUF_THREAD_LOCAL)
+    char line_log_buf[ELOG_LINE_BUF_SIZE];
+#endif
+    char   *log_buf  = is_isr ? isr_line_log_buf : line_log_buf;
+    int     log_len  = -1;
+    uint8_t type      = ELOG_RECORD_TEXT;
+    bool    truncated = false;
+    bool    in_place  = false;
+    va_list fmt_args;
 
-    va_end(args);
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE) && ELOG_ASYNC_ISR_BUF_SIZE > 0
+    extern bool elog_async_isr_lane_enabled(void);
 
-    if (fmt_result < 0)
+    if (is_isr && elog_async_isr_lane_enabled())
     {
-        // failed to format the log message, so we should not output it
-        elog_output_unlock(is_isr);
+        output_log_isr(site, format, args);
+        return;
+    }
+#endif
+
+#if defined(ELOG_ASYNC_ZERO_COPY_ENABLE) || defined(LINE_BUF_SHARED)
+    /* the log is formatted straight into the ring buffer or into the shared line buffer, under the output lock */
+    bool format_locked = true;
+#else
+    bool format_locked = is_isr;
+#endif
+
+    if (!format_locked)
+    {
+        va_copy(fmt_args, args);
+        log_len = format_line_log(log_buf, ELOG_LINE_BUF_SIZE, &type, &truncated, format, fmt_args);
+        va_end(fmt_args);
+
+        if (log_len < 0)
+        {
+            // failed to format the log message, so we should not output it
+            return;
+        }
+    }
+
+    if (!elog_output_lock(is_isr))
+    {
+        // If we fail to get the lock, increase the sequence number to indicate a skipped log message
+        atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+        ELOG_STATS_ADD(lock_fails, 1);
+        elog_count_drops(1);
         return;
     }
 
-    if (fmt_result > (ELOG_LINE_BUF_SIZE - header_size))
+    /* the consumer learns about earlier drops before it gets this log */
+    if (!output_gap(is_isr, site->level))
     {
-        fmt_result = ELOG_LINE_BUF_SIZE - header_size;
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        elog_output_unlock(is_isr);
+        return;
     }
+    /* the counter is read once for the calibration and the log */
+    elog_timestamp_t timestamp = record_time();
+    output_calib(is_isr, site->level, timestamp);
 
-    size_t log_len = fmt_result;
+#if defined(ELOG_ASYNC_ZERO_COPY_ENABLE)
+    extern char *elog_async_reserve(uint8_t level, size_t *capacity);
 
-    // If last character is not a newline, add one
-    size_t newline_len = strlen(ELOG_NEWLINE_SIGN);
-    size_t log_end     = header_size + log_len;
-    if (strcmp(line_log_buf + log_end - newline_len, ELOG_NEWLINE_SIGN) != 0)
+    size_t capacity = 0;
+    char  *slot     = elog_async_reserve(site->level, &capacity);
+    if (slot != NULL && capacity > sizeof(elog_header_t) + strlen(ELOG_NEWLINE_SIGN) + 1)
     {
-        if ((log_end + newline_len) > ELOG_LINE_BUF_SIZE)
+        va_copy(fmt_args, args);
+        log_len = format_line_log(slot, capacity, &type, &truncated, format, fmt_args);
+        va_end(fmt_args);
+
+        /* a slot shorter than the line buffer may have truncated the log, format it the usual way instead */
+        in_place = (log_len >= 0)
+                   && (capacity >= ELOG_LINE_BUF_SIZE || (size_t)log_len < capacity - sizeof(elog_header_t) - 1);
+        if (in_place)
         {
-            memcpy(line_log_buf + ELOG_LINE_BUF_SIZE - newline_len, ELOG_NEWLINE_SIGN, newline_len);
-            log_len += ELOG_LINE_BUF_SIZE;
+            log_buf = slot;
         }
-        else
+    }
+#endif /* ELOG_ASYNC_ZERO_COPY_ENABLE */
+
+    if (format_locked && !in_place)
+    {
+        va_copy(fmt_args, args);
+        log_len = format_line_log(log_buf, ELOG_LINE_BUF_SIZE, &type, &truncated, format, fmt_args);
+        va_end(fmt_args);
+
+        if (log_len < 0)
         {
-            memcpy(line_log_buf + log_end, ELOG_NEWLINE_SIGN, newline_len);
-            log_len += newline_len;
+            elog_output_unlock(is_isr);
+            return;
         }
     }
 
-    // Copy the log header into the buffer
+    // Create header for current log
+    elog_header_t log_header = {0};
+    log_header.seq_num        = atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+    log_header.level          = site->level;
+    log_header.type           = type;
+    log_header.site_id        = elog_site_id(site);
+    log_header.timestamp      = timestamp;
     log_header.message_length = log_len;
-    memcpy(line_log_buf, &log_header, sizeof(elog_header_t));
+    memcpy(log_buf, &log_header, sizeof(elog_header_t));
 
 /* output log */
 #if defined(ELOG_ASYNC_OUTPUT_ENABLE)
-    extern void elog_async_output(uint8_t level, const char *log, size_t size);
-    elog_async_output(level, line_log_buf, log_header.message_length + sizeof(elog_header_t));
+    extern bool elog_async_output(bool is_isr, uint8_t level, const char *log, size_t size);
+    extern void elog_async_commit(size_t size);
+    if (in_place)
+    {
+        elog_async_commit(log_header.message_length + sizeof(elog_header_t));
+    }
+    else if (!elog_async_output(is_isr, site->level, log_buf, log_header.message_length + sizeof(elog_header_t)))
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        elog_output_unlock(is_isr);
+        return;
+    }
 #else
-    elog_port_output(line_log_buf, log_len);
+    elog_port_output(log_buf, log_header.message_length + sizeof(elog_header_t));
 #endif
+    ELOG_STATS_ADD(records, 1);
+    ELOG_STATS_ADD(bytes, log_header.message_length + sizeof(elog_header_t));
+    if (truncated)
+    {
+        ELOG_STATS_ADD(truncations, 1);
+    }
     /* unlock output */
     elog_output_unlock(is_isr);
 }
 
+#if defined(ELOG_RATE_LIMIT_ENABLE)
+/* call-site bucket state fields */
+#define RATE_LIMIT_VALID  0x80
+#define RATE_LIMIT_TOKENS 0x7F
+
+#if ELOG_RATE_LIMIT_BURST > RATE_LIMIT_TOKENS || ELOG_RATE_LIMIT_BURST < 1
+    #error "ELOG_RATE_LIMIT_BURST must be 1 to 127"
+#endif
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/* the buckets run on the cycle counter, a suppressed log doesn't read the wall time */
+    #if ELOG_RATE_LIMIT_INTERVAL * ELOG_TIME_COUNTER_FREQ < ELOG_FMT_TIME_FREQ
+        #error "ELOG_RATE_LIMIT_INTERVAL must be at least one counter tick"
+    #endif
+    /* counter ticks of ELOG_RATE_LIMIT_INTERVAL at the nominal counter rate */
+    #define RATE_LIMIT_TICKS ((uint64_t)ELOG_RATE_LIMIT_INTERVAL * ELOG_TIME_COUNTER_FREQ / ELOG_FMT_TIME_FREQ)
+#else
+    #define RATE_LIMIT_TICKS ELOG_RATE_LIMIT_INTERVAL
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+
+/**
+ * get the current time of the buckets, in ELOG_RATE_LIMIT_INTERVAL units (24 bits)
+ *
+ * @return bucket time
+ */
+static uint32_t rate_limit_now (void)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+
+    elog_timestamp_t time = record_time();
+
+    return (((uint64_t)time.high << 32 | time.low) / RATE_LIMIT_TICKS) & 0xFFFFFF;
+}
+
+/**
+ * get the tokens of a bucket state after the refill up to a time
+ * The bucket state packs the refill time (in ELOG_RATE_LIMIT_INTERVAL units, 24 bits), a valid flag
+ * and the tokens (7 bits) into one word, so it is updated with a single compare and swap.
+ *
+ * @param bucket bucket state
+ * @param now bucket time
+ *
+ * @return tokens, at most ELOG_RATE_LIMIT_BURST
+ */
+static uint32_t rate_limit_tokens (uint32_t bucket, uint32_t now)
+{
+    uint32_t tokens;
+
+    if (bucket & RATE_LIMIT_VALID)
+    {
+        tokens = (bucket & RATE_LIMIT_TOKENS) + ((now - (bucket >> 8)) & 0xFFFFFF);
+    }
+    else
+    {
+        /* the call site never logged, its bucket starts full */
+        tokens = ELOG_RATE_LIMIT_BURST;
+    }
+    return (tokens > ELOG_RATE_LIMIT_BURST) ? ELOG_RATE_LIMIT_BURST : tokens;
+}
+
+/**
+ * take a token from the call site's bucket
+ *
+ * @param site call-site descriptor
+ * @param suppressed number of logs suppressed since the last successful take
+ *
+ * @return true when the log may be output
+ */
+static bool rate_limit_take (const elog_site_t *site, uint32_t *suppressed)
+{
+    uint32_t           now    = rate_limit_now();
+    elog_site_state_t *state  = site->state;
+    uint32_t           bucket = __atomic_load_n(&state->bucket, __ATOMIC_RELAXED);
+    uint32_t           tokens;
+
+    do
+    {
+        tokens = rate_limit_tokens(bucket, now);
+        if (tokens == 0)
+        {
+            __atomic_fetch_add(&state->suppressed, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&state->bucket, &bucket, (now << 8) | RATE_LIMIT_VALID | (tokens - 1), true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    *suppressed = __atomic_exchange_n(&state->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+/**
+ * output the summary of the logs a call site had suppressed
+ *
+ * @param is_isr called from interrupt context
+ * @param site call-site descriptor
+ * @param format summary format
+ * @param ... args
+ */
+static void output_summary (bool is_isr, const elog_site_t *site, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    output_log(is_isr, site, format, args);
+    va_end(args);
+}
+
+/**
+ * output the summary of every call site which logs were suppressed and which bucket is full again, so a
+ * burst that ended is reported without waiting for its call site to log again. The summary takes no
+ * token, a call site that is still in its burst keeps its suppressed logs for its next summary.
+ * elog_async_output_batch calls it every ELOG_RATE_LIMIT_INTERVAL, without asynchronous output the
+ * application calls it periodically.
+ */
+void elog_rate_limit_flush (void)
+{
+    uint32_t now = rate_limit_now();
+
+    for (const elog_site_t *site = __start_elog_sites; site < __stop_elog_sites; site++)
+    {
+        elog_site_state_t *state = site->state;
+        uint32_t           suppressed;
+
+        if (__atomic_load_n(&state->suppressed, __ATOMIC_RELAXED) == 0
+            || rate_limit_tokens(__atomic_load_n(&state->bucket, __ATOMIC_RELAXED), now) < ELOG_RATE_LIMIT_BURST)
+        {
+            continue;
+        }
+        suppressed = __atomic_exchange_n(&state->suppressed, 0, __ATOMIC_RELAXED);
+        if (suppressed != 0)
+        {
+            output_summary(false, site, "suppressed %lu logs of this call site", (unsigned long)suppressed);
+        }
+    }
+}
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+/**
+ * output the log
+ *
+ * @param is_isr called from interrupt context
+ * @param site call-site descriptor, it carries the level, tag, file, function and line
+ * @param format output format
+ * @param ... args
+ *
+ */
+void elog_output (bool is_isr, const elog_site_t *site, const char *format, ...)
+{
+    va_list args;
+
+    /* check output enabled */
+    if (!elog.output_enabled)
+    {
+        return;
+    }
+
+#if defined(ELOG_RATE_LIMIT_ENABLE)
+    /* the rate limit is checked before anything is formatted, a suppressed log only costs the bucket update */
+    uint32_t suppressed = 0;
+    if (!rate_limit_take(site, &suppressed))
+    {
+        return;
+    }
+    if (suppressed != 0)
+    {
+        /* the burst has ended, summarize it in front of the log */
+        output_summary(is_isr, site, "suppressed %lu logs of this call site", (unsigned long)suppressed);
+    }
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+#if defined(ELOG_STATS_ENABLE)
+    uint32_t start = elog_stats_time();
+#endif
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    output_log(is_isr, site, format, args);
+    va_end(args);
+
+#if defined(ELOG_STATS_ENABLE)
+    elog_stats_hist(elog_stats_counter.output_time, start);
+#endif
+}
+
+#if defined(ELOG_HEXDUMP_ENABLE) || defined(ELOG_KV_ENABLE)
+#if defined(LINE_BUF_SHARED)
+    /* the records are packed into the shared line buffer, under the output lock */
+    #define RECORD_PACK_LOCKED true
+#else
+    #define RECORD_PACK_LOCKED false
+#endif
+
+#if !defined(ELOG_ASYNC_OUTPUT_ENABLE)
+/* text of the record rendered under the output lock */
+static char record_text_buf[ELOG_LINE_BUF_SIZE];
+
+/**
+ * render the payload of a hexdump or structured record to text
+ *
+ * @param type record type
+ * @param payload record payload
+ * @param len payload length
+ * @param out text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+static size_t render_record (uint8_t type, const char *payload, size_t len, char *out, size_t size)
+{
+#if defined(ELOG_HEXDUMP_ENABLE)
+    extern size_t elog_hexdump_render(const char *payload, size_t len, char *out, size_t size);
+    if (type == ELOG_RECORD_HEX)
+    {
+        return elog_hexdump_render(payload, len, out, size);
+    }
+#endif
+#if defined(ELOG_KV_ENABLE)
+    extern size_t elog_kv_render(const char *payload, size_t len, char *out, size_t size);
+    if (type == ELOG_RECORD_KV)
+    {
+        return elog_kv_render(payload, len, out, size);
+    }
+#endif
+    return 0;
+}
+#endif /* !ELOG_ASYNC_OUTPUT_ENABLE */
+
+/**
+ * take the output lock for a record from task context, the record is dropped when it is taken
+ *
+ * @return false when the record was dropped
+ */
+static bool record_lock (void)
+{
+    if (!elog_output_lock(false))
+    {
+        atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+        ELOG_STATS_ADD(lock_fails, 1);
+        elog_count_drops(1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * output a record which payload is rendered by the drain, from task context
+ * Without asynchronous output it is rendered here.
+ *
+ * @param site call-site descriptor
+ * @param type record type
+ * @param record header space and payload
+ * @param len payload length
+ * @param locked the caller took the output lock with record_lock, the record is in the shared line buffer
+ *
+ * @return false when the record was dropped
+ */
+static bool output_record (const elog_site_t *site, uint8_t type, char *record, size_t len, bool locked)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+
+    elog_header_t header = {0};
+
+    if (!locked && !record_lock())
+    {
+        return false;
+    }
+    if (!output_gap(false, site->level))
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        elog_output_unlock(false);
+        return false;
+    }
+    header.timestamp = record_time();
+    output_calib(false, site->level, header.timestamp);
+
+    header.seq_num        = atomic_fetch_add_explicit(&g_seq_num, 1, memory_order_release);
+    header.level          = site->level;
+    header.type           = type;
+    header.site_id        = elog_site_id(site);
+    header.message_length = len;
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    extern bool elog_async_output(bool is_isr, uint8_t level, const char *log, size_t size);
+
+    memcpy(record, &header, sizeof(elog_header_t));
+    if (!elog_async_output(false, site->level, record, header.message_length + sizeof(elog_header_t)))
+    {
+        ELOG_STATS_ADD(ring_drops, 1);
+        elog_count_drops(1);
+        elog_output_unlock(false);
+        return false;
+    }
+#else
+    char *text            = record_text_buf;
+    header.type           = ELOG_RECORD_TEXT;
+    header.message_length = render_record(type, record + sizeof(elog_header_t), len, text + sizeof(elog_header_t),
+                                          sizeof(record_text_buf) - sizeof(elog_header_t));
+    memcpy(text, &header, sizeof(elog_header_t));
+    elog_port_output(text, header.message_length + sizeof(elog_header_t));
+#endif
+    ELOG_STATS_ADD(records, 1);
+    ELOG_STATS_ADD(bytes, header.message_length + sizeof(elog_header_t));
+    elog_output_unlock(false);
+    return true;
+}
+#endif /* ELOG_HEXDUMP_ENABLE || ELOG_KV_ENABLE */
+
+#if defined(ELOG_HEXDUMP_ENABLE)
+/**
+ * output a hexdump from task context, elog_hexdump does the checks before it
+ * The bytes are copied into records of ELOG_HEXDUMP_CHUNK_SIZE with their offset in the buffer, the hex
+ * text is rendered by the drain (elog_hexdump_render). The records are packed in the line buffer of the
+ * task, under the output lock when it is the shared one.
+ *
+ * @param site call-site descriptor
+ * @param buf bytes
+ * @param size number of bytes
+ */
+void elog_hexdump_output (const elog_site_t *site, const void *buf, size_t size)
+{
+#if defined(ELOG_LINE_BUF_ON_STACK) && !defined(ELOG_LINE_BUF_THREAD_LOCAL)
+    char line_log_buf[sizeof(elog_header_t) + sizeof(uint32_t) + ELOG_HEXDUMP_CHUNK_SIZE];
+#endif
+
+    if (!elog.output_enabled)
+    {
+        return;
+    }
+
+    for (size_t offset = 0; offset < size; offset += ELOG_HEXDUMP_CHUNK_SIZE)
+    {
+        size_t   len       = (size - offset < ELOG_HEXDUMP_CHUNK_SIZE) ? size - offset : ELOG_HEXDUMP_CHUNK_SIZE;
+        uint32_t offset_32 = (uint32_t)offset;
+
+        if (RECORD_PACK_LOCKED && !record_lock())
+        {
+            continue;
+        }
+        /* the producer only copies, the record is rendered by the drain */
+        memcpy(line_log_buf + sizeof(elog_header_t), &offset_32, sizeof(offset_32));
+        memcpy(line_log_buf + sizeof(elog_header_t) + sizeof(offset_32), (const char *)buf + offset, len);
+        output_record(site, ELOG_RECORD_HEX, line_log_buf, sizeof(offset_32) + len, RECORD_PACK_LOCKED);
+    }
+}
+#endif /* ELOG_HEXDUMP_ENABLE */
+
+#if defined(ELOG_KV_ENABLE)
+/**
+ * output a structured log from task context, elog_kv does the checks before it
+ * The fields are packed in binary (elog_kv_pack) and rendered to text or JSON by the drain. They are packed
+ * in the line buffer of the task, under the output lock when it is the shared one.
+ *
+ * @param site call-site descriptor
+ * @param fields fields
+ * @param num number of fields
+ */
+void elog_kv_output (const elog_site_t *site, const elog_kv_t *fields, size_t num)
+{
+    extern size_t elog_kv_pack(char *payload, size_t size, const elog_kv_t *fields, size_t num, bool *truncated);
+
+#if defined(ELOG_LINE_BUF_ON_STACK) && !defined(ELOG_LINE_BUF_THREAD_LOCAL)
+    char line_log_buf[ELOG_LINE_BUF_SIZE];
+#endif
+    bool   truncated = false;
+    size_t len;
+
+    if (!elog.output_enabled)
+    {
+        return;
+    }
+
+    if (RECORD_PACK_LOCKED && !record_lock())
+    {
+        return;
+    }
+    len = elog_kv_pack(line_log_buf + sizeof(elog_header_t), ELOG_LINE_BUF_SIZE - sizeof(elog_header_t), fields, num,
+                       &truncated);
+    if (output_record(site, ELOG_RECORD_KV, line_log_buf, len, RECORD_PACK_LOCKED) && truncated)
+    {
+        ELOG_STATS_ADD(truncations, 1);
+    }
+}
+#endif /* ELOG_KV_ENABLE */
+
 /**
  * enable or disable logger output lock
  * @note disable this lock is not recommended except you want output system exception log
@@ -342,3 +1305,37 @@ void elog_output_lock_enabled (bool enabled)
         }
     }
 }
+
+/**
+ * get the compact id of a call-site descriptor, it is the descriptor's index in the call-site section
+ *
+ * @param site call-site descriptor
+ *
+ * @return call-site id, ELOG_SITE_ID_NONE when the descriptor isn't in the call-site section
+ */
+uint16_t elog_site_id (const elog_site_t *site)
+{
+    if (site < __start_elog_sites || site >= __stop_elog_sites || site - __start_elog_sites >= ELOG_SITE_ID_NONE)
+    {
+        return ELOG_SITE_ID_NONE;
+    }
+
+    return (uint16_t)(site - __start_elog_sites);
+}
+
+/**
+ * find the call-site descriptor of a record
+ *
+ * @param site_id call-site id from elog_header_t
+ *
+ * @return call-site descriptor, NULL when the id is unknown
+ */
+const elog_site_t *elog_find_site (uint16_t site_id)
+{
+    if (site_id >= __stop_elog_sites - __start_elog_sites)
+    {
+        return NULL;
+    }
+
+    return &__start_elog_sites[site_id];
+}
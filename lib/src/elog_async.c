@@ -29,6 +29,7 @@
 #include <elog.h>
 #include <string.h>
 #include <elog_ring_buf.h>
+#include <elog_stats.h>
 
 /* the highest output level for async mode, other level will sync output */
 #ifdef ELOG_ASYNC_OUTPUT_LVL
@@ -37,30 +38,471 @@
     #define OUTPUT_LVL ELOG_LVL_ASSERT
 #endif /* ELOG_ASYNC_OUTPUT_LVL */
 
+/* number of logs handed to elog_port_output_batch at once */
+#ifndef ELOG_ASYNC_OUTPUT_BATCH_NUM
+    #define ELOG_ASYNC_OUTPUT_BATCH_NUM 16
+#endif /* ELOG_ASYNC_OUTPUT_BATCH_NUM */
+
+/* what to do with a new log when the ring buffer is full */
+#ifndef ELOG_ASYNC_OVERFLOW_POLICY
+    #define ELOG_ASYNC_OVERFLOW_POLICY ELOG_ASYNC_OVERFLOW_DROP_NEWEST
+#endif /* ELOG_ASYNC_OVERFLOW_POLICY */
+
+/* longest wait for room with ELOG_ASYNC_OVERFLOW_BLOCK, in elog_port_get_time units */
+#ifndef ELOG_ASYNC_BLOCK_TIMEOUT
+    #define ELOG_ASYNC_BLOCK_TIMEOUT 10
+#endif /* ELOG_ASYNC_BLOCK_TIMEOUT */
+
+/* ring buffer space only logs at ELOG_ASYNC_RESERVE_LVL or more severe may use */
+#ifndef ELOG_ASYNC_RESERVE_SIZE
+    #define ELOG_ASYNC_RESERVE_SIZE 0
+#endif /* ELOG_ASYNC_RESERVE_SIZE */
+
+#ifndef ELOG_ASYNC_RESERVE_LVL
+    #define ELOG_ASYNC_RESERVE_LVL ELOG_LVL_ERROR
+#endif /* ELOG_ASYNC_RESERVE_LVL */
+
+/* buffer size of the lane for everything that doesn't go to the ISR or high severity lane */
+#ifdef ELOG_ASYNC_OUTPUT_BUF_SIZE
+    #define OUTPUT_BUF_SIZE ELOG_ASYNC_OUTPUT_BUF_SIZE
+#else
+    #define OUTPUT_BUF_SIZE (ELOG_LINE_BUF_SIZE * 10)
+#endif /* ELOG_ASYNC_OUTPUT_BUF_SIZE */
+
+/* high severity lane size, 0: the high severity logs share the output lane */
+#ifndef ELOG_ASYNC_HIGH_BUF_SIZE
+    #define ELOG_ASYNC_HIGH_BUF_SIZE 0
+#endif /* ELOG_ASYNC_HIGH_BUF_SIZE */
+
+/* logs at this level or more severe go to the high severity lane */
+#ifndef ELOG_ASYNC_HIGH_LVL
+    #define ELOG_ASYNC_HIGH_LVL ELOG_LVL_ERROR
+#endif /* ELOG_ASYNC_HIGH_LVL */
+
+/* number of lanes, the output lane is the last one */
+#define LANE_NUM    (1 + (ELOG_ASYNC_ISR_BUF_SIZE > 0) + (ELOG_ASYNC_HIGH_BUF_SIZE > 0))
+#define OUTPUT_LANE (&lanes[LANE_NUM - 1])
+
 /* asynchronous output mode enabled flag */
 static bool is_enabled = false;
 
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+#if defined(ELOG_DEFERRED_FMT_ENABLE)
+    #error "ELOG_ASYNC_PERSIST_ENABLE can't keep deferred records, their format and string pointers don't survive a reset"
+#endif
+
+/* "ELOG", the region holds lanes */
+#define PERSIST_MAGIC 0x454C4F47
+
+/*
+ * Region of elog_port_persist_region:
+ *
+ *   | persist_head_t | ISR lane storage | high severity lane storage | output lane storage |
+ *
+ * The ring buffers themselves are in the head, so their indices survive a reset along with the records.
+ * The output lane takes the rest of the region.
+ */
+typedef struct
+{
+    uint32_t        magic;
+    elog_ring_buf_t lanes[LANE_NUM];
+} persist_head_t;
+
+/* lanes before elog_init placed them in the region, they have no room, so every log is dropped */
+static elog_ring_buf_t  unplaced_lanes[LANE_NUM];
+/* lanes, the drain merges them by sequence number */
+static elog_ring_buf_t *lanes = unplaced_lanes;
+/* logs of the previous boot found by elog_async_init */
+static size_t           recovered_count;
+#else
+/* lane storage, every lane is a separate ring buffer */
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+static _Alignas(elog_header_t) char isr_lane_buf[ELOG_ASYNC_ISR_BUF_SIZE];
+#endif
+#if ELOG_ASYNC_HIGH_BUF_SIZE > 0
+static _Alignas(elog_header_t) char high_lane_buf[ELOG_ASYNC_HIGH_BUF_SIZE];
+#endif
+static _Alignas(elog_header_t) char output_lane_buf[OUTPUT_BUF_SIZE];
+
+/* lanes, the drain merges them by sequence number */
+static elog_ring_buf_t lanes[LANE_NUM] = {
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+    ELOG_RING_BUF_INIT(isr_lane_buf),
+#endif
+#if ELOG_ASYNC_HIGH_BUF_SIZE > 0
+    ELOG_RING_BUF_INIT(high_lane_buf),
+#endif
+    ELOG_RING_BUF_INIT(output_lane_buf),
+};
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
+/* lane of the record got by elog_async_peek_line_log, only touched by the single consumer */
+static elog_ring_buf_t *peeked_lane;
+/* lane of the slot reserved by elog_async_reserve, only touched under the output lock */
+static elog_ring_buf_t *reserved_lane;
+
+#if LANE_NUM > 1
+/* records every lane had for the last elog_async_peek_line_logs, only touched by the single consumer */
+static elog_span_t lane_logs[LANE_NUM][ELOG_ASYNC_OUTPUT_BATCH_NUM];
+static size_t      lane_counts[LANE_NUM];
+/* lane of every merged record */
+static uint8_t     merged_lanes[ELOG_ASYNC_OUTPUT_BATCH_NUM];
+#endif /* LANE_NUM > 1 */
+
+/* records rendered to text by the drain: gap markers, deferred, hexdump and structured ones */
+#if defined(ELOG_DEFERRED_FMT_ENABLE) || defined(ELOG_HEXDUMP_ENABLE) || defined(ELOG_KV_ENABLE)
+    #define RECORD_RENDERED(header)                                                                                    \
+        ((header)->type == ELOG_RECORD_GAP || (header)->type == ELOG_RECORD_DEFERRED                                   \
+         || (header)->type == ELOG_RECORD_HEX || (header)->type == ELOG_RECORD_KV)
+#else
+    #define RECORD_RENDERED(header) ((header)->type == ELOG_RECORD_GAP)
+#endif
+
+/* records that can't be handed out in place: compact headers are expanded and rendered records rendered */
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    #define RECORD_COPIED(header) true
+#else
+    #define RECORD_COPIED(header) RECORD_RENDERED(header)
+#endif
+
+/* records copied by the drain, only touched by the single consumer */
+static _Alignas(elog_header_t) char drain_record_buf[ELOG_LINE_BUF_SIZE];
+
+/* rendered record for direct output, only touched under the output lock */
+static char output_record_buf[ELOG_LINE_BUF_SIZE];
+
+extern size_t elog_gap_render (const char *payload, size_t len, char *out, size_t size);
+
+#if defined(ELOG_DEFERRED_FMT_ENABLE)
+extern size_t elog_deferred_render (const char *payload, size_t len, char *out, size_t size);
+#endif /* ELOG_DEFERRED_FMT_ENABLE */
+#if defined(ELOG_HEXDUMP_ENABLE)
+extern size_t elog_hexdump_render (const char *payload, size_t len, char *out, size_t size);
+#endif /* ELOG_HEXDUMP_ENABLE */
+#if defined(ELOG_KV_ENABLE)
+extern size_t elog_kv_render (const char *payload, size_t len, char *out, size_t size);
+#endif /* ELOG_KV_ENABLE */
+
+/**
+ * copy a record to a text record with a whole header, a gap marker, deferred, hexdump or structured record
+ * is rendered, a gap marker keeps its type
+ *
+ * @param header record header
+ * @param payload record payload
+ * @param out text record buffer
+ * @param size text record buffer size, bigger than the header
+ *
+ * @return text record size, 0 when a text record doesn't fit (a rendered one is truncated instead)
+ */
+static size_t copy_record (const elog_header_t *header, const char *payload, char *out, size_t size)
+{
+    elog_header_t text_header = *header;
+
+    if (header->type == ELOG_RECORD_GAP)
+    {
+        text_header.message_length = elog_gap_render(payload, header->message_length, out + sizeof(elog_header_t),
+                                                     size - sizeof(elog_header_t));
+    }
+    else
+#if defined(ELOG_DEFERRED_FMT_ENABLE)
+    if (header->type == ELOG_RECORD_DEFERRED)
+    {
+        text_header.message_length = elog_deferred_render(payload, header->message_length, out + sizeof(elog_header_t),
+                                                          size - sizeof(elog_header_t));
+        text_header.type           = ELOG_RECORD_TEXT;
+    }
+    else
+#endif /* ELOG_DEFERRED_FMT_ENABLE */
+#if defined(ELOG_HEXDUMP_ENABLE)
+    if (header->type == ELOG_RECORD_HEX)
+    {
+        text_header.message_length = elog_hexdump_render(payload, header->message_length, out + sizeof(elog_header_t),
+                                                         size - sizeof(elog_header_t));
+        text_header.type           = ELOG_RECORD_TEXT;
+    }
+    else
+#endif /* ELOG_HEXDUMP_ENABLE */
+#if defined(ELOG_KV_ENABLE)
+    if (header->type == ELOG_RECORD_KV)
+    {
+        text_header.message_length = elog_kv_render(payload, header->message_length, out + sizeof(elog_header_t),
+                                                    size - sizeof(elog_header_t));
+        text_header.type           = ELOG_RECORD_TEXT;
+    }
+    else
+#endif /* ELOG_KV_ENABLE */
+    {
+        if (size - sizeof(elog_header_t) < header->message_length)
+        {
+            return 0;
+        }
+        memcpy(out + sizeof(elog_header_t), payload, header->message_length);
+    }
+    memcpy(out, &text_header, sizeof(elog_header_t));
+
+    return text_header.message_length + sizeof(elog_header_t);
+}
+
 extern void elog_port_output (const char *log, size_t size);
-extern void elog_output_lock (bool is_isr);
-extern void elog_output_unlock (bool is_isr);
+
+#if ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_BLOCK
+/**
+ * wait port interface, called while a task waits for the drain to make room in the full ring buffer
+ * The default spins, a port should yield or sleep a tick instead (the output lock stays taken).
+ */
+__attribute__((weak)) void elog_port_output_wait (void)
+{
+}
+
+static uint64_t block_time (void)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+
+    elog_timestamp_t time = elog_port_get_time();
+    return (uint64_t)time.high << 32 | time.low;
+}
+#endif /* ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_BLOCK */
 
 /**
- * put log to asynchronous output ring buffer
+ * get the lane of a log
  *
+ * @param is_isr called from interrupt context
+ * @param level log level
+ *
+ * @return lane
+ */
+static elog_ring_buf_t *lane_of (bool is_isr, uint8_t level)
+{
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+    if (is_isr)
+    {
+        return &lanes[0];
+    }
+#endif
+#if ELOG_ASYNC_HIGH_BUF_SIZE > 0
+    if (level <= ELOG_ASYNC_HIGH_LVL)
+    {
+        return &lanes[LANE_NUM - 2];
+    }
+#endif
+    (void)is_isr;
+    (void)level;
+    return OUTPUT_LANE;
+}
+
+#if defined(ELOG_STATS_ENABLE)
+/**
+ * raise the high-watermark of a lane after a log was put on it
+ *
+ * @param lane lane
+ */
+static void stats_peak (elog_ring_buf_t *lane)
+{
+    uint8_t id = ELOG_STATS_LANE_OUTPUT;
+
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+    if (lane == &lanes[0])
+    {
+        id = ELOG_STATS_LANE_ISR;
+    }
+#endif
+#if ELOG_ASYNC_HIGH_BUF_SIZE > 0
+    if (lane == &lanes[LANE_NUM - 2])
+    {
+        id = ELOG_STATS_LANE_HIGH;
+    }
+#endif
+    elog_stats_peak(id, elog_buf_used(lane));
+}
+#else
+#define stats_peak(lane) ((void)0)
+#endif /* ELOG_STATS_ENABLE */
+
+/**
+ * compare the sequence numbers of two records, taking the wrap around into account
+ *
+ * @return true when the first record is older
+ */
+static bool record_older (const elog_header_t *header, const elog_header_t *other)
+{
+    return (int32_t)(header->seq_num - other->seq_num) < 0;
+}
+
+#if LANE_NUM > 1
+/**
+ * Get the sequence number bound of a merge, it is read before the lanes are looked at. A record at or
+ * above it may have been published after an earlier lane was looked at while an older record of that
+ * lane wasn't, or an older record may still be on its way into a lane, so it is left for the next merge.
+ *
+ * @return sequence number of the next log, or of the oldest log that isn't published yet
+ */
+static uint32_t merge_bound (void)
+{
+    extern uint32_t elog_next_seq_num(void);
+
+    return elog_next_seq_num();
+}
+
+/**
+ * compare the sequence number of a record with a merge bound, taking the wrap around into account
+ *
+ * @return true when the record may be merged
+ */
+static bool record_below (const elog_header_t *header, uint32_t bound)
+{
+    return (int32_t)(header->seq_num - bound) < 0;
+}
+#endif /* LANE_NUM > 1 */
+
+/**
+ * get the oldest top record of all lanes in place, it is held until it is released on its lane
+ * The lanes are looked at one after another, records at or above the merge bound are left, so a record
+ * published on a lane that was already looked at can't come after a newer one of another lane.
+ *
+ * @param record oldest top record
+ * @param size oldest top record size
+ *
+ * @return lane of the record, NULL when all lanes are empty
+ */
+static elog_ring_buf_t *peek_oldest (const char **record, size_t *size)
+{
+    elog_ring_buf_t *oldest = NULL;
+    elog_header_t    oldest_header;
+#if LANE_NUM > 1
+    uint32_t bound = merge_bound();
+#endif
+
+    for (size_t i = 0; i < LANE_NUM; i++)
+    {
+        const char   *top;
+        size_t        top_size;
+        elog_header_t top_header;
+
+        if (elog_buf_peek_span(&lanes[i], &top, &top_size) != 0)
+        {
+            continue;
+        }
+        elog_buf_decode(&lanes[i], top, &top_header);
+#if LANE_NUM > 1
+        if (!record_below(&top_header, bound))
+        {
+            elog_buf_release(&lanes[i], 0);
+            continue;
+        }
+#endif
+        if (oldest != NULL && !record_older(&top_header, &oldest_header))
+        {
+            elog_buf_release(&lanes[i], 0);
+            continue;
+        }
+        if (oldest != NULL)
+        {
+            elog_buf_release(oldest, 0);
+        }
+        oldest        = &lanes[i];
+        oldest_header = top_header;
+        *record       = top;
+        *size         = top_size;
+    }
+
+    return oldest;
+}
+
+/**
+ * ring buffer space the log must leave free
+ *
+ * @param level log level
+ *
+ * @return size of the reserve for the more severe levels, 0 when the log may use it
+ */
+static size_t reserve_size (uint8_t level)
+{
+    return (level > ELOG_ASYNC_RESERVE_LVL) ? ELOG_ASYNC_RESERVE_SIZE : 0;
+}
+
+/**
+ * put log to asynchronous output ring buffer, a full ring buffer is handled by ELOG_ASYNC_OVERFLOW_POLICY
+ *
+ * @param is_isr called from interrupt context
+ * @param level log level
  * @param log put log buffer
  * @param size log size
  *
- * @return void
+ * @return false when the log was dropped
  */
-static void async_put_log (const char *log, size_t size)
+static bool async_put_log (bool is_isr, uint8_t level, const char *log, size_t size)
 {
-    // If the buffer is full, the log will be dropped
-    elog_buf_push(log, size);
+    elog_ring_buf_t *lane    = lane_of(is_isr, level);
+    size_t           reserve = reserve_size(level);
+
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+    if (lane == &lanes[0])
+    {
+        /* interrupts don't hold the output lock, the ISR lane is pushed lock-free and drops when full */
+        return elog_buf_push_shared(lane, log, size) == 0;
+    }
+#endif
+
+#if ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_OVERWRITE_OLDEST
+    extern void elog_count_evicted(const elog_header_t *header, const char *message);
+
+    elog_span_t evicted[ELOG_RING_EVICT_MAX];
+    size_t      evicted_count;
+
+    (void)is_isr;
+    if (size + reserve > elog_buf_used(lane) + elog_buf_avail(lane))
+    {
+        /* evicting the whole ring buffer wouldn't make room for it */
+        return false;
+    }
+#elif ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_BLOCK
+    uint64_t start   = 0;
+    bool     waiting = false;
+#endif
+
+    while ((reserve != 0 && elog_buf_avail(lane) < size + reserve) || elog_buf_push(lane, log, size) != 0)
+    {
+#if ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_OVERWRITE_OLDEST
+        evicted_count = elog_buf_evict(lane, evicted, ELOG_RING_EVICT_MAX);
+        if (evicted_count == 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < evicted_count; i++)
+        {
+            elog_header_t header;
+            size_t        header_size = elog_buf_parse(evicted[i].data, &header);
+            elog_count_evicted(&header, evicted[i].data + header_size);
+        }
+#elif ELOG_ASYNC_OVERFLOW_POLICY == ELOG_ASYNC_OVERFLOW_BLOCK
+        if (is_isr)
+        {
+            return false;
+        }
+        if (!waiting)
+        {
+            start   = block_time();
+            waiting = true;
+        }
+        else if (block_time() - start >= ELOG_ASYNC_BLOCK_TIMEOUT)
+        {
+            return false;
+        }
+        elog_port_output_wait();
+#else
+        (void)is_isr;
+        return false;
+#endif
+    }
+
+    return true;
 }
 
 /**
  * Get line log from asynchronous output ring buffer.
  * It will copy all log when the newline sign isn't find.
+ * The ring buffer is lock-free on the read side, so a single drain task may call this
+ * without taking the output lock.
  *
  * @param log get line log buffer
  * @param size line log size
@@ -69,37 +511,581 @@ static void async_put_log (const char *log, size_t size)
  */
 ElogErrCode elog_async_get_line_log (char *log, size_t size)
 {
+    const char      *record;
+    size_t           record_size;
+    elog_ring_buf_t *lane = peek_oldest(&record, &record_size);
 
-    elog_header_t top_log_header;
-    int           ret = elog_buf_peek(&top_log_header);
-    if (ret != 0)
+    if (lane == NULL)
     {
         return ELOG_NO_LOG;
     }
 
-    size_t total_log_line_size = top_log_header.message_length + sizeof(elog_header_t);
-    if (size < total_log_line_size)
+    elog_header_t top_log_header;
+    size_t        header_size = elog_buf_decode(lane, record, &top_log_header);
+    if (RECORD_COPIED(&top_log_header))
+    {
+        /* a deferred text is rendered into the caller's buffer, truncated to its size */
+        size_t log_size = (size > sizeof(elog_header_t)) ? copy_record(&top_log_header, record + header_size, log, size)
+                                                         : 0;
+        elog_buf_release(lane, (log_size != 0) ? record_size : 0);
+        return (log_size != 0) ? ELOG_NO_ERR : ELOG_INPUT_ERR;
+    }
+
+    if (size < record_size)
     {
         // Current buf is not big enough to contain the whole log line
+        elog_buf_release(lane, 0);
         return ELOG_INPUT_ERR;
     }
 
-    elog_buf_pop(log, total_log_line_size);
+    memcpy(log, record, record_size);
+    elog_buf_release(lane, record_size);
     return ELOG_NO_ERR;
 }
 
-void elog_async_output (uint8_t level, const char *log, size_t size)
+/**
+ * Get the top line log in place, without copying it out of the asynchronous output ring buffer.
+ * The log stays valid until it is released by elog_async_release_line_log.
+ *
+ * @param log top line log, header and message
+ * @param size top line log size
+ *
+ * @return ELOG_NO_LOG when the ring buffer is empty
+ */
+ElogErrCode elog_async_peek_line_log (const char **log, size_t *size)
+{
+    peeked_lane = peek_oldest(log, size);
+    if (peeked_lane == NULL)
+    {
+        return ELOG_NO_LOG;
+    }
+
+    elog_header_t top_log_header;
+    size_t        header_size = elog_buf_decode(peeked_lane, *log, &top_log_header);
+    if (RECORD_COPIED(&top_log_header))
+    {
+        /* the copy is made on the drain side, the ring buffer keeps the record until release */
+        *size = copy_record(&top_log_header, *log + header_size, drain_record_buf, sizeof(drain_record_buf));
+        *log  = drain_record_buf;
+    }
+
+    return ELOG_NO_ERR;
+}
+
+/**
+ * Release the top line log got by elog_async_peek_line_log.
+ */
+void elog_async_release_line_log (void)
+{
+    const char *record;
+    size_t      record_size;
+
+    if (peeked_lane != NULL && elog_buf_peek_span(peeked_lane, &record, &record_size) == 0)
+    {
+        elog_buf_release(peeked_lane, record_size);
+    }
+    peeked_lane = NULL;
+}
+
+/**
+ * copy a record that can't be handed out in place to the drain buffer
+ *
+ * @param log record, it is replaced by its copy
+ * @param header record header
+ * @param header_size size of the header in front of the message
+ * @param used drain buffer space the batch has used
+ *
+ * @return false when the drain buffer is used up, the record is left for the next batch
+ */
+static bool drain_record (elog_span_t *log, const elog_header_t *header, size_t header_size, size_t *used)
+{
+    size_t room = (*used < sizeof(drain_record_buf)) ? sizeof(drain_record_buf) - *used : 0;
+    size_t size = 0;
+
+    if (!RECORD_COPIED(header))
+    {
+        return true;
+    }
+    if (room > sizeof(elog_header_t) + 1)
+    {
+        size = copy_record(header, log->data + header_size, drain_record_buf + *used, room);
+    }
+    if (*used != 0 && (size == 0 || size + 1 >= room))
+    {
+        return false;
+    }
+
+    log->data = drain_record_buf + *used;
+    log->size = size;
+    *used += (size + _Alignof(elog_header_t) - 1) / _Alignof(elog_header_t) * _Alignof(elog_header_t);
+    return true;
+}
+
+#if LANE_NUM > 1
+/**
+ * merge the records of all lanes by sequence number, the records at or above the merge bound are left
+ *
+ * @param logs merged records
+ * @param max_count maximum number of records, not more than ELOG_ASYNC_OUTPUT_BATCH_NUM
+ *
+ * @return number of records
+ */
+static size_t merge_lanes (elog_span_t *logs, size_t max_count)
+{
+    elog_header_t heads[LANE_NUM];
+    size_t        head_sizes[LANE_NUM] = {0};
+    size_t        taken[LANE_NUM]      = {0};
+    size_t        count                = 0;
+    size_t        used                 = 0;
+    uint32_t      bound                = merge_bound();
+
+    for (size_t i = 0; i < LANE_NUM; i++)
+    {
+        lane_counts[i] = elog_buf_peek_batch(&lanes[i], lane_logs[i], max_count);
+        if (lane_counts[i] != 0)
+        {
+            head_sizes[i] = elog_buf_decode(&lanes[i], lane_logs[i][0].data, &heads[i]);
+        }
+    }
+
+    for (; count < max_count; count++)
+    {
+        size_t oldest = LANE_NUM;
+
+        for (size_t i = 0; i < LANE_NUM; i++)
+        {
+            if (taken[i] < lane_counts[i] && record_below(&heads[i], bound)
+                && (oldest == LANE_NUM || record_older(&heads[i], &heads[oldest])))
+            {
+                oldest = i;
+            }
+        }
+        if (oldest == LANE_NUM)
+        {
+            break;
+        }
+
+        logs[count] = lane_logs[oldest][taken[oldest]];
+        if (!drain_record(&logs[count], &heads[oldest], head_sizes[oldest], &used))
+        {
+            /* the drain buffer is used up, the rest is left for the next batch */
+            break;
+        }
+        merged_lanes[count] = oldest;
+        /* the records of a lane are decoded in order */
+        if (++taken[oldest] < lane_counts[oldest])
+        {
+            head_sizes[oldest] = elog_buf_decode(&lanes[oldest], lane_logs[oldest][taken[oldest]].data, &heads[oldest]);
+        }
+    }
+
+    return count;
+}
+#endif /* LANE_NUM > 1 */
+
+/**
+ * Get up to max_count line logs in place, without copying them out of the asynchronous output ring buffer.
+ * The logs of all lanes are merged by sequence number, at most ELOG_ASYNC_OUTPUT_BATCH_NUM of them when
+ * there is more than one lane. Rendered logs (gap markers, deferred, hexdump, structured) and compact
+ * headers are copied to a drain buffer, so fewer logs may be got when it is used up. The logs stay valid
+ * until they are released by elog_async_release_line_logs.
+ *
+ * @param logs line logs, header and message each
+ * @param max_count maximum number of line logs
+ *
+ * @return number of line logs
+ */
+size_t elog_async_peek_line_logs (elog_span_t *logs, size_t max_count)
+{
+#if LANE_NUM > 1
+    return merge_lanes(logs, (max_count < ELOG_ASYNC_OUTPUT_BATCH_NUM) ? max_count : ELOG_ASYNC_OUTPUT_BATCH_NUM);
+#else
+    size_t count = elog_buf_peek_batch(OUTPUT_LANE, logs, max_count);
+    size_t used  = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        elog_header_t header;
+        size_t        header_size = elog_buf_decode(OUTPUT_LANE, logs[i].data, &header);
+        if (!drain_record(&logs[i], &header, header_size, &used))
+        {
+            /* the drain buffer is used up, the rest is left for the next batch */
+            count = i;
+            break;
+        }
+    }
+
+    return count;
+#endif /* LANE_NUM > 1 */
+}
+
+/**
+ * Release the line logs got by elog_async_peek_line_logs.
+ *
+ * @param count number of line logs
+ */
+void elog_async_release_line_logs (size_t count)
+{
+#if LANE_NUM > 1
+    size_t released[LANE_NUM] = {0};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        released[merged_lanes[i]]++;
+    }
+    for (size_t i = 0; i < LANE_NUM; i++)
+    {
+        /* every lane that had records is held, even when none of them was merged */
+        if (lane_counts[i] != 0)
+        {
+            elog_buf_release_batch(&lanes[i], released[i]);
+            lane_counts[i] = 0;
+        }
+    }
+#else
+    elog_buf_release_batch(OUTPUT_LANE, count);
+#endif
+}
+
+/**
+ * output batch port interface, the default outputs the logs one by one with elog_port_output
+ * A port can replace it to push many logs with one DMA transfer or writev.
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+__attribute__((weak)) void elog_port_output_batch (const elog_span_t *logs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        elog_port_output(logs[i].data, logs[i].size);
+    }
+}
+
+#if defined(ELOG_ASYNC_COMPRESS_ENABLE)
+/* text of the lines drained by one elog_async_output_batch call, compressed into a frame when it is full */
+#ifndef ELOG_ASYNC_COMPRESS_BLOCK_SIZE
+    #define ELOG_ASYNC_COMPRESS_BLOCK_SIZE 1024
+#endif /* ELOG_ASYNC_COMPRESS_BLOCK_SIZE */
+
+#if ELOG_ASYNC_COMPRESS_BLOCK_SIZE > 65535
+    #error "ELOG_ASYNC_COMPRESS_BLOCK_SIZE must not exceed 65535"
+#endif
+
+/* block and frame, only touched by the single drain task */
+static char   compress_block[ELOG_ASYNC_COMPRESS_BLOCK_SIZE];
+static size_t compress_used;
+static char   compress_frame[ELOG_LZ_FRAME_SIZE(ELOG_ASYNC_COMPRESS_BLOCK_SIZE)];
+
+extern void elog_port_output_frame (const char *frame, size_t size);
+
+static void compress_flush (void)
+{
+    if (compress_used == 0)
+    {
+        return;
+    }
+
+    size_t size = elog_lz_frame_encode(compress_block, compress_used, compress_frame, sizeof(compress_frame));
+    elog_port_output_frame(compress_frame, size);
+    compress_used = 0;
+}
+
+/**
+ * render logs into the compression block, lines longer than the block are cut
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+static void compress_logs (const elog_span_t *logs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+        elog_header_t header;
+        memcpy(&header, logs[i].data, sizeof(elog_header_t));
+        /* a calibration record has no line, it must not look like a line that didn't fit */
+        if (header.type == ELOG_RECORD_CALIB)
+        {
+            elog_render_calibrate(logs[i].data);
+            continue;
+        }
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+        size_t room = sizeof(compress_block) - compress_used;
+        size_t len  = elog_render(logs[i].data, logs[i].size, compress_block + compress_used, room);
+
+        /* the line was cut to the room left or didn't fit at all, render it again into an empty block */
+        if ((len == room || len == 0) && compress_used != 0)
+        {
+            compress_flush();
+            len = elog_render(logs[i].data, logs[i].size, compress_block, sizeof(compress_block));
+        }
+        compress_used += len;
+        if (compress_used == sizeof(compress_block))
+        {
+            compress_flush();
+        }
+    }
+}
+
+#define output_logs(logs, count) compress_logs(logs, count)
+#else
+#define output_logs(logs, count) elog_port_output_batch(logs, count)
+#endif /* ELOG_ASYNC_COMPRESS_ENABLE */
+
+#if defined(ELOG_RATE_LIMIT_ENABLE)
+/**
+ * output the summaries of the ended bursts every ELOG_RATE_LIMIT_INTERVAL, called by the single drain task
+ */
+static void rate_limit_poll (void)
+{
+    extern elog_timestamp_t elog_port_get_time(void);
+
+    static uint64_t last_time = 0;
+
+    elog_timestamp_t stamp = elog_port_get_time();
+    uint64_t         time  = (uint64_t)stamp.high << 32 | stamp.low;
+
+    if (time - last_time >= ELOG_RATE_LIMIT_INTERVAL)
+    {
+        last_time = time;
+        elog_rate_limit_flush();
+    }
+}
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+/**
+ * Drain up to max_count logs from the asynchronous output ring buffer to elog_port_output_batch,
+ * ELOG_ASYNC_OUTPUT_BATCH_NUM logs per call. It must only be called by the single drain task.
+ * With ELOG_ASYNC_COMPRESS_ENABLE the logs are rendered and compressed instead, and the frames go to
+ * elog_port_output_frame. The last frame is output before it returns, so no log is held back.
+ * With ELOG_RATE_LIMIT_ENABLE it also outputs the summaries of the suppressed logs whose burst has ended.
+ *
+ * @param max_count maximum number of logs
+ *
+ * @return number of output logs
+ */
+size_t elog_async_output_batch (size_t max_count)
+{
+    elog_span_t logs[ELOG_ASYNC_OUTPUT_BATCH_NUM];
+    size_t      total = 0;
+
+    while (total < max_count)
+    {
+        size_t count = max_count - total;
+        if (count > ELOG_ASYNC_OUTPUT_BATCH_NUM)
+        {
+            count = ELOG_ASYNC_OUTPUT_BATCH_NUM;
+        }
+
+        count = elog_async_peek_line_logs(logs, count);
+        if (count == 0)
+        {
+            break;
+        }
+
+#if defined(ELOG_STATS_ENABLE)
+        uint32_t start = elog_stats_time();
+        output_logs(logs, count);
+        elog_stats_hist(elog_stats_counter.drain_time, start);
+#else
+        output_logs(logs, count);
+#endif
+        elog_async_release_line_logs(count);
+        total += count;
+    }
+
+#if defined(ELOG_ASYNC_COMPRESS_ENABLE)
+    compress_flush();
+#endif
+
+#if defined(ELOG_RATE_LIMIT_ENABLE)
+    rate_limit_poll();
+#endif
+#if defined(ELOG_STATS_ENABLE)
+    elog_stats_poll();
+#endif
+
+    return total;
+}
+
+/**
+ * reserve a ring buffer slot, so the log can be formatted in place
+ * It must be called with the output lock held, the log is published by elog_async_commit.
+ * The overflow policy isn't applied here, a log which doesn't fit goes through elog_async_output.
+ *
+ * @param level log level
+ * @param capacity slot capacity
+ *
+ * @return slot, NULL when asynchronous output mode is disabled or the ring buffer is full
+ */
+char *elog_async_reserve (uint8_t level, size_t *capacity)
+{
+    size_t reserve = reserve_size(level);
+    size_t size    = ELOG_LINE_BUF_SIZE;
+
+    if (!is_enabled)
+    {
+        return NULL;
+    }
+    reserved_lane = lane_of(false, level);
+    if (reserve != 0)
+    {
+        size_t avail = elog_buf_avail(reserved_lane);
+        if (avail <= reserve)
+        {
+            return NULL;
+        }
+        if (size > avail - reserve)
+        {
+            size = avail - reserve;
+        }
+    }
+
+    return elog_buf_reserve(reserved_lane, size, capacity);
+}
+
+/**
+ * publish the log formatted in the slot reserved by elog_async_reserve
+ *
+ * @param size log size, header and message
+ */
+void elog_async_commit (size_t size)
+{
+    elog_buf_commit(reserved_lane, size);
+    stats_peak(reserved_lane);
+}
+
+/**
+ * output the log to the asynchronous output ring buffer, or directly when the mode is disabled
+ * It must be called with the output lock held.
+ *
+ * @param is_isr called from interrupt context
+ * @param level log level
+ * @param log log, header and message
+ * @param size log size
+ *
+ * @return false when the log was dropped
+ */
+bool elog_async_output (bool is_isr, uint8_t level, const char *log, size_t size)
 {
     if (is_enabled)
     {
-        async_put_log(log, size);
+        if (!async_put_log(is_isr, level, log, size))
+        {
+            return false;
+        }
+        stats_peak(lane_of(is_isr, level));
+        return true;
     }
     else
     {
+        elog_header_t header;
+        memcpy(&header, log, sizeof(elog_header_t));
+        if (RECORD_RENDERED(&header))
+        {
+            size = copy_record(&header, log + sizeof(elog_header_t), output_record_buf, sizeof(output_record_buf));
+            log  = output_record_buf;
+        }
         elog_port_output(log, size);
+        return true;
     }
 }
 
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+/**
+ * place the lanes in the region of elog_port_persist_region and recover the logs the previous boot left
+ * there, they are drained first because the sequence numbers go on behind them
+ * It must be called before the drain starts.
+ *
+ * @return result, ELOG_INIT_FAIL when the region is missing, misaligned or too small
+ */
+ElogErrCode elog_async_init (void)
+{
+    extern char *elog_port_persist_region(size_t *size);
+    extern void  elog_set_seq_num(uint32_t seq_num);
+
+    size_t lane_sizes[LANE_NUM] = {
+#if ELOG_ASYNC_ISR_BUF_SIZE > 0
+        ELOG_ASYNC_ISR_BUF_SIZE / _Alignof(elog_header_t) * _Alignof(elog_header_t),
+#endif
+#if ELOG_ASYNC_HIGH_BUF_SIZE > 0
+        ELOG_ASYNC_HIGH_BUF_SIZE / _Alignof(elog_header_t) * _Alignof(elog_header_t),
+#endif
+        0,
+    };
+    size_t   region_size = 0;
+    char    *region      = elog_port_persist_region(&region_size);
+    size_t   used        = sizeof(persist_head_t);
+    bool     any_seq     = false;
+    uint32_t newest_seq  = 0;
+
+    for (size_t i = 0; i + 1 < LANE_NUM; i++)
+    {
+        used += lane_sizes[i];
+    }
+    if (region == NULL || (uintptr_t)region % _Alignof(persist_head_t) != 0
+        || region_size < used + ELOG_LINE_BUF_SIZE)
+    {
+        return ELOG_INIT_FAIL;
+    }
+    lane_sizes[LANE_NUM - 1] = (region_size - used) / _Alignof(elog_header_t) * _Alignof(elog_header_t);
+
+    persist_head_t *head    = (persist_head_t *)region;
+    char           *storage = region + sizeof(persist_head_t);
+    recovered_count         = 0;
+    for (size_t i = 0; i < LANE_NUM; i++)
+    {
+        if (head->magic == PERSIST_MAGIC)
+        {
+            uint32_t seq;
+            size_t   count = elog_buf_recover(&head->lanes[i], storage, lane_sizes[i], &seq);
+
+            if (count != 0 && (!any_seq || (int32_t)(seq - newest_seq) > 0))
+            {
+                newest_seq = seq;
+                any_seq    = true;
+            }
+            recovered_count += count;
+        }
+        else
+        {
+            elog_buf_init(&head->lanes[i], storage, lane_sizes[i]);
+        }
+        storage += lane_sizes[i];
+    }
+    head->magic = PERSIST_MAGIC;
+    lanes       = head->lanes;
+
+    if (any_seq)
+    {
+        elog_set_seq_num(newest_seq + 1);
+    }
+
+    return ELOG_NO_ERR;
+}
+
+/**
+ * get the number of logs of the previous boot elog_async_init recovered
+ *
+ * @return number of recovered logs
+ */
+size_t elog_async_recovered (void)
+{
+    return recovered_count;
+}
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
+/**
+ * check if interrupt context logs go to the ISR lane, without taking the output lock
+ *
+ * @return true when asynchronous output mode is enabled and has an ISR lane
+ */
+bool elog_async_isr_lane_enabled (void)
+{
+    return (ELOG_ASYNC_ISR_BUF_SIZE > 0) && is_enabled;
+}
+
 /**
  * enable or disable asynchronous output mode
  * the log will be output directly when mode is disabled
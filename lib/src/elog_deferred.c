@@ -0,0 +1,520 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Deferred formatting, packs raw args on the producer and renders them on the drain.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Deferred record payload:
+ *
+ *   | const char *format | arg 0 | arg 1 | ... |
+ *
+ * Every arg is stored unaligned in its native size. Strings are copied as a uint16_t length followed
+ * by the characters, because the caller's string may be gone by the time the record is drained.
+ * Width and precision given by '*' are stored as int before the converted arg.
+ */
+
+#if defined(ELOG_DEFERRED_FMT_ENABLE)
+
+/* longest conversion specification that will be rebuilt for rendering */
+#define SPEC_MAX_LEN 32
+
+typedef enum
+{
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_SKIP, /* %n, the arg is consumed and nothing is written */
+} arg_class_t;
+
+typedef struct
+{
+    char        flags[6];
+    int         width;     /* -1: none */
+    int         precision; /* -1: none */
+    bool        width_arg;
+    bool        precision_arg;
+    char        length[3];
+    char        conversion;
+    arg_class_t arg;
+} fmt_spec_t;
+
+/**
+ * parse one conversion specification
+ *
+ * @param p format position right behind the '%'
+ * @param spec parsed specification
+ *
+ * @return format position behind the specification
+ */
+static const char *parse_spec (const char *p, fmt_spec_t *spec)
+{
+    size_t n = 0;
+
+    memset(spec, 0, sizeof(fmt_spec_t));
+    spec->width     = -1;
+    spec->precision = -1;
+
+    while (*p && strchr("-+ #0", *p) && n < sizeof(spec->flags) - 1)
+    {
+        spec->flags[n++] = *p++;
+    }
+
+    if (*p == '*')
+    {
+        spec->width_arg = true;
+        p++;
+    }
+    else if (*p >= '0' && *p <= '9')
+    {
+        for (spec->width = 0; *p >= '0' && *p <= '9'; p++)
+        {
+            spec->width = spec->width * 10 + (*p - '0');
+        }
+    }
+
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            spec->precision_arg = true;
+            p++;
+        }
+        else
+        {
+            for (spec->precision = 0; *p >= '0' && *p <= '9'; p++)
+            {
+                spec->precision = spec->precision * 10 + (*p - '0');
+            }
+        }
+    }
+
+    for (n = 0; *p && strchr("hljztL", *p) && n < sizeof(spec->length) - 1; n++)
+    {
+        spec->length[n] = *p++;
+    }
+
+    spec->conversion = *p;
+    if (*p)
+    {
+        p++;
+    }
+
+    switch (spec->conversion)
+    {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            if (strcmp(spec->length, "l") == 0)
+            {
+                spec->arg = ARG_LONG;
+            }
+            else if (strcmp(spec->length, "ll") == 0)
+            {
+                spec->arg = ARG_LLONG;
+            }
+            else if (strcmp(spec->length, "j") == 0)
+            {
+                spec->arg = ARG_INTMAX;
+            }
+            else if (strcmp(spec->length, "z") == 0)
+            {
+                spec->arg = ARG_SIZE;
+            }
+            else if (strcmp(spec->length, "t") == 0)
+            {
+                spec->arg = ARG_PTRDIFF;
+            }
+            else
+            {
+                spec->arg = ARG_INT;
+            }
+            break;
+        case 'c':
+            spec->arg = ARG_INT;
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec->arg = (strcmp(spec->length, "L") == 0) ? ARG_LDOUBLE : ARG_DOUBLE;
+            break;
+        case 'p':
+            spec->arg = ARG_PTR;
+            break;
+        case 's':
+            spec->arg = ARG_STR;
+            break;
+        case 'n':
+            spec->arg = ARG_SKIP;
+            break;
+        default:
+            spec->arg = ARG_NONE;
+            break;
+    }
+
+    return p;
+}
+
+/* append raw bytes to the payload, false when it is full */
+static bool pack_bytes (char *payload, size_t size, size_t *pos, const void *data, size_t len)
+{
+    if (*pos + len > size)
+    {
+        return false;
+    }
+    memcpy(payload + *pos, data, len);
+    *pos += len;
+    return true;
+}
+
+#define PACK_ARG(type)                                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        type value = va_arg(args, type);                                                                               \
+        if (!pack_bytes(payload, size, &pos, &value, sizeof(value)))                                                   \
+        {                                                                                                              \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+    } while (0)
+
+/**
+ * pack the format pointer and the raw args into a deferred record payload
+ *
+ * @param payload payload buffer
+ * @param size payload buffer size
+ * @param format output format, it must stay valid until the record is rendered
+ * @param args args
+ *
+ * @return payload length, -1 when the args don't fit into the payload buffer
+ */
+int elog_deferred_pack (char *payload, size_t size, const char *format, va_list args)
+{
+    size_t     pos = 0;
+    fmt_spec_t spec;
+
+    if (!pack_bytes(payload, size, &pos, &format, sizeof(format)))
+    {
+        return -1;
+    }
+
+    for (const char *p = format; *p;)
+    {
+        if (*p++ != '%')
+        {
+            continue;
+        }
+        if (*p == '%')
+        {
+            p++;
+            continue;
+        }
+
+        p = parse_spec(p, &spec);
+        if (spec.width_arg)
+        {
+            PACK_ARG(int);
+        }
+        if (spec.precision_arg)
+        {
+            int precision = va_arg(args, int);
+            spec.precision = precision;
+            if (!pack_bytes(payload, size, &pos, &precision, sizeof(precision)))
+            {
+                return -1;
+            }
+        }
+
+        switch (spec.arg)
+        {
+            case ARG_INT:
+                PACK_ARG(int);
+                break;
+            case ARG_LONG:
+                PACK_ARG(long);
+                break;
+            case ARG_LLONG:
+                PACK_ARG(long long);
+                break;
+            case ARG_INTMAX:
+                PACK_ARG(intmax_t);
+                break;
+            case ARG_SIZE:
+                PACK_ARG(size_t);
+                break;
+            case ARG_PTRDIFF:
+                PACK_ARG(ptrdiff_t);
+                break;
+            case ARG_DOUBLE:
+                PACK_ARG(double);
+                break;
+            case ARG_LDOUBLE:
+                PACK_ARG(long double);
+                break;
+            case ARG_PTR:
+                PACK_ARG(void *);
+                break;
+            case ARG_STR:
+            {
+                const char *str = va_arg(args, const char *);
+                if (str == NULL)
+                {
+                    str = "(null)";
+                }
+
+                size_t len = strlen(str);
+                if (spec.precision >= 0 && len > (size_t)spec.precision)
+                {
+                    len = spec.precision;
+                }
+                if (len > UINT16_MAX)
+                {
+                    len = UINT16_MAX;
+                }
+
+                uint16_t str_len = len;
+                if (!pack_bytes(payload, size, &pos, &str_len, sizeof(str_len))
+                    || !pack_bytes(payload, size, &pos, str, len))
+                {
+                    return -1;
+                }
+                break;
+            }
+            case ARG_SKIP:
+                (void)va_arg(args, void *);
+                break;
+            case ARG_NONE:
+                break;
+        }
+    }
+
+    return (int)pos;
+}
+
+/* take raw bytes from the payload, false when it is exhausted */
+static bool unpack_bytes (const char *payload, size_t len, size_t *pos, void *data, size_t size)
+{
+    if (*pos + size > len)
+    {
+        return false;
+    }
+    memcpy(data, payload + *pos, size);
+    *pos += size;
+    return true;
+}
+
+/* rebuild the conversion specification with the resolved width and precision */
+static void build_spec (const fmt_spec_t *spec, char *out)
+{
+    int n = snprintf(out, SPEC_MAX_LEN, "%%%s", spec->flags);
+
+    if (spec->width >= 0)
+    {
+        n += snprintf(out + n, SPEC_MAX_LEN - n, "%d", spec->width);
+    }
+    if (spec->precision >= 0)
+    {
+        n += snprintf(out + n, SPEC_MAX_LEN - n, ".%d", spec->precision);
+    }
+    snprintf(out + n, SPEC_MAX_LEN - n, "%s%c", spec->length, spec->conversion);
+}
+
+#define RENDER_ARG(type)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        type value;                                                                                                    \
+        if (!unpack_bytes(payload, len, &pos, &value, sizeof(value)))                                                  \
+        {                                                                                                              \
+            goto done;                                                                                                 \
+        }                                                                                                              \
+        written = snprintf(out + out_len, max_len - out_len + 1, spec_str, value);                                     \
+    } while (0)
+
+/**
+ * render a deferred record payload to text, the text always ends with a newline sign
+ *
+ * @param payload deferred record payload
+ * @param len payload length
+ * @param out text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+size_t elog_deferred_render (const char *payload, size_t len, char *out, size_t size)
+{
+    extern size_t elog_line_terminate(char *message, size_t log_len, size_t max_len);
+
+    const char *format;
+    size_t      pos     = 0;
+    size_t      out_len = 0;
+    size_t      max_len = size - 1;
+    fmt_spec_t  spec;
+    char        spec_str[SPEC_MAX_LEN];
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (!unpack_bytes(payload, len, &pos, &format, sizeof(format)))
+    {
+        goto done;
+    }
+
+    for (const char *p = format; *p && out_len < max_len;)
+    {
+        /* copy the literal text up to the next conversion */
+        const char *next = strchr(p, '%');
+        size_t      span = next ? (size_t)(next - p) : strlen(p);
+        if (span > max_len - out_len)
+        {
+            span = max_len - out_len;
+        }
+        memcpy(out + out_len, p, span);
+        out_len += span;
+        p += span;
+
+        if (*p != '%')
+        {
+            continue;
+        }
+        p++;
+        if (*p == '%')
+        {
+            out[out_len++] = '%';
+            p++;
+            continue;
+        }
+
+        p = parse_spec(p, &spec);
+        if (spec.width_arg && !unpack_bytes(payload, len, &pos, &spec.width, sizeof(int)))
+        {
+            goto done;
+        }
+        if (spec.width_arg && spec.width < 0)
+        {
+            /* negative '*' width means left justified */
+            spec.width = -spec.width;
+            strncat(spec.flags, "-", sizeof(spec.flags) - strlen(spec.flags) - 1);
+        }
+        if (spec.precision_arg && !unpack_bytes(payload, len, &pos, &spec.precision, sizeof(int)))
+        {
+            goto done;
+        }
+        if (spec.precision_arg && spec.precision < 0)
+        {
+            spec.precision = -1;
+        }
+
+        int written = 0;
+        switch (spec.arg)
+        {
+            case ARG_INT:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(int);
+                break;
+            case ARG_LONG:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(long);
+                break;
+            case ARG_LLONG:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(long long);
+                break;
+            case ARG_INTMAX:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(intmax_t);
+                break;
+            case ARG_SIZE:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(size_t);
+                break;
+            case ARG_PTRDIFF:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(ptrdiff_t);
+                break;
+            case ARG_DOUBLE:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(double);
+                break;
+            case ARG_LDOUBLE:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(long double);
+                break;
+            case ARG_PTR:
+                build_spec(&spec, spec_str);
+                RENDER_ARG(void *);
+                break;
+            case ARG_STR:
+            {
+                uint16_t str_len;
+                if (!unpack_bytes(payload, len, &pos, &str_len, sizeof(str_len)) || pos + str_len > len)
+                {
+                    goto done;
+                }
+                /* the copied string isn't terminated, so its length becomes the precision */
+                spec.precision = str_len;
+                build_spec(&spec, spec_str);
+                written = snprintf(out + out_len, max_len - out_len + 1, spec_str, str_len ? payload + pos : "");
+                pos += str_len;
+                break;
+            }
+            case ARG_SKIP:
+            case ARG_NONE:
+                break;
+        }
+
+        if (written > 0)
+        {
+            out_len += ((size_t)written > max_len - out_len) ? max_len - out_len : (size_t)written;
+        }
+    }
+
+done:
+    return elog_line_terminate(out, out_len, max_len);
+}
+
+#endif /* ELOG_DEFERRED_FMT_ENABLE */
@@ -0,0 +1,333 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Runtime level and tag filter with per call-site cached decisions.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <string.h>
+
+/* tag level filter */
+typedef struct
+{
+    char    tag[ELOG_FILTER_TAG_MAX_LEN + 1];
+    uint8_t level;
+    bool    tag_use_flag;
+} ElogTagLvlFilter;
+
+/* global output level filter */
+static uint8_t filter_lvl = ELOG_FILTER_LVL_ALL;
+/* tag level filter hash table, open addressing with linear probing */
+static ElogTagLvlFilter tag_lvl[ELOG_FILTER_TAG_LVL_MAX_NUM];
+
+/*
+ * The filter generation works like a sequence lock. It is odd while a filter setting is being changed
+ * and even otherwise, starting at 2 so a zero initialized call-site state is always stale. Call sites
+ * cache their decision together with the generation it was made in and only look at the filter again
+ * after the generation moved on. A call site racing with a setter may decide on a half updated filter
+ * once, but it never caches that decision.
+ */
+uint32_t elog_filter_gen = 2;
+
+extern bool elog_output_lock (bool is_isr);
+extern bool elog_output_unlock (bool is_isr);
+
+static uint32_t tag_hash (const char *tag)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    while (*tag)
+    {
+        hash = (hash ^ (uint8_t)*tag++) * 16777619u;
+    }
+
+    return hash % ELOG_FILTER_TAG_LVL_MAX_NUM;
+}
+
+/**
+ * find the tag in the tag level filter table
+ *
+ * @param tag tag
+ *
+ * @return table index, -1 when the tag isn't in the table
+ */
+static int find_tag_lvl (const char *tag)
+{
+    uint32_t index = tag_hash(tag);
+
+    for (size_t i = 0; i < ELOG_FILTER_TAG_LVL_MAX_NUM; i++)
+    {
+        if (!tag_lvl[index].tag_use_flag)
+        {
+            return -1;
+        }
+        if (strcmp(tag_lvl[index].tag, tag) == 0)
+        {
+            return index;
+        }
+        index = (index + 1) % ELOG_FILTER_TAG_LVL_MAX_NUM;
+    }
+
+    return -1;
+}
+
+/**
+ * remove the entry from the tag level filter table, later entries of the probe chain are moved up
+ *
+ * @param index table index
+ */
+static void remove_tag_lvl (uint32_t index)
+{
+    uint32_t next = index;
+
+    tag_lvl[index].tag_use_flag = false;
+    for (;;)
+    {
+        next = (next + 1) % ELOG_FILTER_TAG_LVL_MAX_NUM;
+        if (!tag_lvl[next].tag_use_flag)
+        {
+            break;
+        }
+
+        /* move the entry to the hole unless its home slot lies cyclically in (index, next] */
+        uint32_t home = tag_hash(tag_lvl[next].tag);
+        bool     keep = (index <= next) ? (index < home && home <= next) : (index < home || home <= next);
+        if (!keep)
+        {
+            tag_lvl[index]             = tag_lvl[next];
+            tag_lvl[next].tag_use_flag = false;
+            index                      = next;
+        }
+    }
+}
+
+/* a filter setting is about to change, the caller holds the output lock */
+static void filter_update_begin (void)
+{
+    __atomic_store_n(&elog_filter_gen, elog_filter_gen + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* a filter setting has changed, all cached call-site decisions are stale now */
+static void filter_update_end (void)
+{
+    __atomic_store_n(&elog_filter_gen, elog_filter_gen + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * set log filter's level
+ *
+ * @param level level
+ */
+void elog_set_filter_lvl (uint8_t level)
+{
+    if (!elog_output_lock(false))
+    {
+        return;
+    }
+
+    filter_update_begin();
+    filter_lvl = level;
+    filter_update_end();
+
+    elog_output_unlock(false);
+}
+
+/**
+ * get log filter's level
+ *
+ * @return level
+ */
+uint8_t elog_get_filter_lvl (void)
+{
+    return filter_lvl;
+}
+
+/**
+ * Set the filter's level by different tag.
+ * The log on this tag which level is less than it will stop output.
+ *
+ * example:
+ *     // the example tag log enter silent mode
+ *     elog_set_filter_tag_lvl("example", ELOG_FILTER_LVL_SILENT);
+ *     // the example tag log which level is less than INFO level will stop output
+ *     elog_set_filter_tag_lvl("example", ELOG_LVL_INFO);
+ *     // remove example tag's level filter, all level log will resume output
+ *     elog_set_filter_tag_lvl("example", ELOG_FILTER_LVL_ALL);
+ *
+ * @param tag log tag
+ * @param level The filter level. When the level is ELOG_FILTER_LVL_SILENT, the log enter silent mode.
+ *        When the level is ELOG_FILTER_LVL_ALL, it will remove this tag's level filer.
+ *        Then all level log will resume output.
+ *
+ * @return ELOG_INPUT_ERR when the tag is too long or the filter table is full
+ */
+ElogErrCode elog_set_filter_tag_lvl (const char *tag, uint8_t level)
+{
+    ElogErrCode result = ELOG_NO_ERR;
+
+    if (tag == NULL || strlen(tag) > ELOG_FILTER_TAG_MAX_LEN)
+    {
+        return ELOG_INPUT_ERR;
+    }
+    if (!elog_output_lock(false))
+    {
+        return ELOG_INPUT_ERR;
+    }
+
+    filter_update_begin();
+
+    int index = find_tag_lvl(tag);
+    if (index >= 0)
+    {
+        if (level == ELOG_FILTER_LVL_ALL)
+        {
+            remove_tag_lvl(index);
+        }
+        else
+        {
+            tag_lvl[index].level = level;
+        }
+    }
+    else if (level != ELOG_FILTER_LVL_ALL)
+    {
+        uint32_t slot = tag_hash(tag);
+        size_t   i;
+
+        for (i = 0; i < ELOG_FILTER_TAG_LVL_MAX_NUM && tag_lvl[slot].tag_use_flag; i++)
+        {
+            slot = (slot + 1) % ELOG_FILTER_TAG_LVL_MAX_NUM;
+        }
+
+        if (i < ELOG_FILTER_TAG_LVL_MAX_NUM)
+        {
+            strcpy(tag_lvl[slot].tag, tag);
+            tag_lvl[slot].level        = level;
+            tag_lvl[slot].tag_use_flag = true;
+        }
+        else
+        {
+            result = ELOG_INPUT_ERR;
+        }
+    }
+
+    filter_update_end();
+    elog_output_unlock(false);
+
+    return result;
+}
+
+/**
+ * get the level on tag's level filer
+ *
+ * @param tag tag
+ *
+ * @return It will return the lowest level when tag was not found.
+ *         Other level will return when tag was found.
+ */
+uint8_t elog_get_filter_tag_lvl (const char *tag)
+{
+    int index = (tag != NULL) ? find_tag_lvl(tag) : -1;
+
+    return (index >= 0) ? tag_lvl[index].level : ELOG_FILTER_LVL_ALL;
+}
+
+/**
+ * decide the call site against the level and tag filter and cache the decision in its state
+ * It is the slow path of elog_site_enabled, taken once per call site after every filter change.
+ *
+ * @param site call-site descriptor
+ *
+ * @return true when the log should be output
+ */
+bool elog_site_refresh (const elog_site_t *site)
+{
+    uint32_t gen     = __atomic_load_n(&elog_filter_gen, __ATOMIC_ACQUIRE);
+    bool     enabled = site->level <= filter_lvl;
+
+    if (enabled && site->tag != NULL)
+    {
+        enabled = site->level <= elog_get_filter_tag_lvl(site->tag);
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (!(gen & 1) && gen == __atomic_load_n(&elog_filter_gen, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&site->state->filter, gen | enabled, __ATOMIC_RELAXED);
+    }
+
+    return enabled;
+}
+
+/**
+ * find the log level of a record
+ *
+ * @param log record, header and message
+ *
+ * @return log level, -1 when the record is invalid
+ */
+int8_t elog_find_lvl (const char *log)
+{
+    elog_header_t header;
+
+    if (log == NULL)
+    {
+        return -1;
+    }
+
+    memcpy(&header, log, sizeof(elog_header_t));
+    return (header.level < ELOG_LVL_TOTAL_NUM) ? (int8_t)header.level : -1;
+}
+
+/**
+ * find the log tag of a record through its call-site descriptor
+ *
+ * @param log record, header and message
+ * @param lvl log level, it must match the record's level
+ * @param tag_len found tag length
+ *
+ * @return log tag, NULL when the record has no call site or the level doesn't match
+ */
+const char *elog_find_tag (const char *log, uint8_t lvl, size_t *tag_len)
+{
+    elog_header_t      header;
+    const elog_site_t *site;
+
+    if (log == NULL || tag_len == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(&header, log, sizeof(elog_header_t));
+    site = elog_find_site(header.site_id);
+    if (header.level != lvl || site == NULL || site->tag == NULL)
+    {
+        return NULL;
+    }
+
+    *tag_len = strlen(site->tag);
+    return site->tag;
+}
@@ -0,0 +1,120 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Hexdump records, the raw bytes are rendered as hex and ASCII lines on the drain.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <string.h>
+
+/*
+ * Hexdump record payload:
+ *
+ *   | uint32_t offset | bytes |
+ *
+ * The offset is the position of the first byte in the dumped buffer, a dump longer than
+ * ELOG_HEXDUMP_CHUNK_SIZE goes on in records with higher offsets. Every line is
+ *
+ *   00000010  30 31 32 33 34 35 36 37 38 39 3A 3B 3C 3D 3E 3F  |0123456789:;<=>?|
+ *
+ * and the hex text of a byte is taken from a table of all 256 digit pairs.
+ */
+
+#if defined(ELOG_HEXDUMP_ENABLE)
+
+#define HEX_ROW(h) h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" h "8" h "9" h "A" h "B" h "C" h "D" h "E" h "F"
+
+/* two hex digits of 0x00 to 0xFF */
+static const char hex_pairs[] = HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3") HEX_ROW("4") HEX_ROW("5")
+    HEX_ROW("6") HEX_ROW("7") HEX_ROW("8") HEX_ROW("9") HEX_ROW("A") HEX_ROW("B") HEX_ROW("C") HEX_ROW("D")
+    HEX_ROW("E") HEX_ROW("F");
+
+static inline char *put_hex (char *p, uint8_t byte)
+{
+    memcpy(p, &hex_pairs[byte * 2], 2);
+    return p + 2;
+}
+
+/**
+ * render the payload of a hexdump record, only whole lines are rendered
+ *
+ * @param payload record payload
+ * @param len payload length
+ * @param out text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+size_t elog_hexdump_render (const char *payload, size_t len, char *out, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)payload + sizeof(uint32_t);
+    size_t         pos   = 0;
+    uint32_t       offset;
+
+    if (len < sizeof(offset))
+    {
+        return 0;
+    }
+    memcpy(&offset, payload, sizeof(offset));
+    len -= sizeof(offset);
+
+    for (size_t i = 0; i < len && size - pos >= ELOG_HEXDUMP_LINE_LEN; i += ELOG_HEXDUMP_WIDTH)
+    {
+        size_t   num  = (len - i < ELOG_HEXDUMP_WIDTH) ? len - i : ELOG_HEXDUMP_WIDTH;
+        uint32_t addr = offset + (uint32_t)i;
+        char    *p    = out + pos;
+
+        p    = put_hex(p, (uint8_t)(addr >> 24));
+        p    = put_hex(p, (uint8_t)(addr >> 16));
+        p    = put_hex(p, (uint8_t)(addr >> 8));
+        p    = put_hex(p, (uint8_t)addr);
+        *p++ = ' ';
+        *p++ = ' ';
+        for (size_t j = 0; j < num; j++)
+        {
+            p    = put_hex(p, bytes[i + j]);
+            *p++ = ' ';
+        }
+        /* the ASCII column of a short last line stays aligned */
+        memset(p, ' ', (ELOG_HEXDUMP_WIDTH - num) * 3);
+        p += (ELOG_HEXDUMP_WIDTH - num) * 3;
+        *p++ = ' ';
+        *p++ = '|';
+        for (size_t j = 0; j < num; j++)
+        {
+            uint8_t byte = bytes[i + j];
+            *p++         = (byte >= 0x20 && byte < 0x7F) ? (char)byte : '.';
+        }
+        *p++ = '|';
+        memcpy(p, ELOG_NEWLINE_SIGN, sizeof(ELOG_NEWLINE_SIGN) - 1);
+        p += sizeof(ELOG_NEWLINE_SIGN) - 1;
+
+        pos = (size_t)(p - out);
+    }
+
+    return pos;
+}
+
+#endif /* ELOG_HEXDUMP_ENABLE */
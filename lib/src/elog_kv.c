@@ -0,0 +1,492 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Structured logs, typed fields are packed on the producer and rendered to text or JSON on the drain.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Structured record payload, one entry per field:
+ *
+ *   | uint8_t type | uint8_t key length | key | value |
+ *
+ * The key text is copied, so a record kept over a reset by ELOG_ASYNC_PERSIST_ENABLE still renders, a key
+ * is cut to 255 characters. The value is stored unaligned in its native size (bool as one byte). A string is
+ * copied as a uint16_t length followed by the characters. The drain renders the fields as
+ *
+ *   text:  rx=120 err=0 rssi=-71 ssid="my net"
+ *   JSON:  {"rx":120,"err":0,"rssi":-71,"ssid":"my net"}
+ *
+ * Text strings are quoted only when they have a space, '=' or '"' in them.
+ */
+
+#if defined(ELOG_KV_ENABLE)
+
+extern const char elog_digit_pairs[];
+
+/* fields are rendered as JSON objects, set by elog_set_kv_json */
+static bool kv_json = false;
+
+/* text of a rendered record, full once something didn't fit */
+typedef struct
+{
+    char  *text;
+    size_t len;
+    size_t max_len;
+    bool   full;
+} kv_text_t;
+
+/**
+ * render structured logs as JSON objects instead of key=value text, it takes effect on the next drained log
+ *
+ * @param enabled true: JSON, false: text
+ */
+void elog_set_kv_json (bool enabled)
+{
+    __atomic_store_n(&kv_json, enabled, __ATOMIC_RELAXED);
+}
+
+/* add raw bytes to the payload, false when they don't fit */
+static bool pack_bytes (char *payload, size_t size, size_t *pos, const void *data, size_t len)
+{
+    if (*pos + len > size)
+    {
+        return false;
+    }
+    memcpy(payload + *pos, data, len);
+    *pos += len;
+    return true;
+}
+
+/**
+ * pack the fields of a structured log, the fields that don't fit are left out
+ *
+ * @param payload record payload
+ * @param size payload size
+ * @param fields fields
+ * @param num number of fields
+ * @param truncated set when a field was left out or a string was cut
+ *
+ * @return payload length
+ */
+size_t elog_kv_pack (char *payload, size_t size, const elog_kv_t *fields, size_t num, bool *truncated)
+{
+    size_t pos = 0;
+
+    for (size_t i = 0; i < num; i++)
+    {
+        const elog_kv_t *field   = &fields[i];
+        const char      *key     = field->key ? field->key : "(null)";
+        size_t           key_len = strlen(key);
+        size_t           start   = pos;
+        uint8_t          key_len_8;
+        bool             fits;
+
+        if (key_len > UINT8_MAX)
+        {
+            key_len    = UINT8_MAX;
+            *truncated = true;
+        }
+        key_len_8 = (uint8_t)key_len;
+        fits      = pack_bytes(payload, size, &pos, &field->type, sizeof(field->type))
+               && pack_bytes(payload, size, &pos, &key_len_8, sizeof(key_len_8))
+               && pack_bytes(payload, size, &pos, key, key_len);
+
+        switch (field->type)
+        {
+            case ELOG_KV_U32:
+            case ELOG_KV_I32:
+                fits = fits && pack_bytes(payload, size, &pos, &field->value.u32, sizeof(uint32_t));
+                break;
+            case ELOG_KV_U64:
+            case ELOG_KV_I64:
+                fits = fits && pack_bytes(payload, size, &pos, &field->value.u64, sizeof(uint64_t));
+                break;
+            case ELOG_KV_F64:
+                fits = fits && pack_bytes(payload, size, &pos, &field->value.f64, sizeof(double));
+                break;
+            case ELOG_KV_BOOL:
+            {
+                uint8_t value = field->value.b;
+                fits          = fits && pack_bytes(payload, size, &pos, &value, sizeof(value));
+                break;
+            }
+            case ELOG_KV_STR:
+            {
+                const char *str     = field->value.str ? field->value.str : "(null)";
+                size_t      str_len = strlen(str);
+                uint16_t    len_16;
+
+                if (fits && pos + sizeof(len_16) < size)
+                {
+                    /* a long string is cut to the space that is left */
+                    if (str_len > UINT16_MAX || str_len > size - pos - sizeof(len_16))
+                    {
+                        str_len    = (size - pos - sizeof(len_16) < UINT16_MAX) ? size - pos - sizeof(len_16) : UINT16_MAX;
+                        *truncated = true;
+                    }
+                    len_16 = (uint16_t)str_len;
+                    pack_bytes(payload, size, &pos, &len_16, sizeof(len_16));
+                    pack_bytes(payload, size, &pos, str, str_len);
+                }
+                else
+                {
+                    fits = false;
+                }
+                break;
+            }
+            default:
+                fits = false;
+                break;
+        }
+
+        if (!fits)
+        {
+            *truncated = true;
+            return start;
+        }
+    }
+
+    return pos;
+}
+
+/* take raw bytes from the payload, false when it is exhausted */
+static bool unpack_bytes (const char *payload, size_t len, size_t *pos, void *data, size_t size)
+{
+    if (*pos + size > len)
+    {
+        return false;
+    }
+    memcpy(data, payload + *pos, size);
+    *pos += size;
+    return true;
+}
+
+/* append text, nothing more is taken once it is full */
+static void text_put (kv_text_t *text, const char *data, size_t len)
+{
+    if (text->full || len > text->max_len - text->len)
+    {
+        text->full = true;
+        return;
+    }
+    memcpy(text->text + text->len, data, len);
+    text->len += len;
+}
+
+/* append a character */
+static void text_put_char (kv_text_t *text, char c)
+{
+    text_put(text, &c, 1);
+}
+
+/* append an unsigned integer in decimal, two digits per step */
+static void text_put_u64 (kv_text_t *text, uint64_t value)
+{
+    char  digits[20];
+    char *p = digits + sizeof(digits);
+
+    while (value >= 100)
+    {
+        p -= 2;
+        memcpy(p, &elog_digit_pairs[(value % 100) * 2], 2);
+        value /= 100;
+    }
+    if (value >= 10)
+    {
+        p -= 2;
+        memcpy(p, &elog_digit_pairs[value * 2], 2);
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+    text_put(text, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+/* append a signed integer in decimal */
+static void text_put_i64 (kv_text_t *text, int64_t value)
+{
+    if (value < 0)
+    {
+        text_put_char(text, '-');
+        text_put_u64(text, (uint64_t)0 - (uint64_t)value);
+    }
+    else
+    {
+        text_put_u64(text, (uint64_t)value);
+    }
+}
+
+/* append a string in quotes, '"', '\' and control characters are escaped the JSON way */
+static void text_put_quoted (kv_text_t *text, const char *str, size_t len)
+{
+    text_put_char(text, '"');
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)str[i];
+        size_t        span;
+
+        /* copy the run of characters that need no escape at once */
+        for (span = 0; i + span < len; span++)
+        {
+            c = (unsigned char)str[i + span];
+            if (c < 0x20 || c == '"' || c == '\\')
+            {
+                break;
+            }
+        }
+        text_put(text, str + i, span);
+        i += span;
+        if (i == len)
+        {
+            break;
+        }
+        switch (c)
+        {
+            case '"':
+                text_put(text, "\\\"", 2);
+                break;
+            case '\\':
+                text_put(text, "\\\\", 2);
+                break;
+            case '\n':
+                text_put(text, "\\n", 2);
+                break;
+            case '\r':
+                text_put(text, "\\r", 2);
+                break;
+            case '\t':
+                text_put(text, "\\t", 2);
+                break;
+            default:
+            {
+                char escape[6] = {'\\', 'u', '0', '0', "0123456789abcdef"[c >> 4], "0123456789abcdef"[c & 0xF]};
+                text_put(text, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    text_put_char(text, '"');
+}
+
+/* append a string value, a text value is quoted only when it would be ambiguous */
+static void text_put_str (kv_text_t *text, const char *str, size_t len, bool json)
+{
+    bool quote = json || len == 0;
+
+    for (size_t i = 0; i < len && !quote; i++)
+    {
+        quote = str[i] == ' ' || str[i] == '=' || str[i] == '"' || (unsigned char)str[i] < 0x20;
+    }
+    if (quote)
+    {
+        text_put_quoted(text, str, len);
+    }
+    else
+    {
+        text_put(text, str, len);
+    }
+}
+
+/**
+ * render one field
+ *
+ * @param text rendered text
+ * @param payload record payload
+ * @param len payload length
+ * @param pos payload position of the field
+ * @param json render JSON
+ *
+ * @return false when the payload is exhausted or broken
+ */
+static bool render_field (kv_text_t *text, const char *payload, size_t len, size_t *pos, bool json)
+{
+    uint8_t     type;
+    uint8_t     key_len;
+    const char *key;
+
+    if (!unpack_bytes(payload, len, pos, &type, sizeof(type)) || !unpack_bytes(payload, len, pos, &key_len, sizeof(key_len))
+        || *pos + key_len > len)
+    {
+        return false;
+    }
+    key   = payload + *pos;
+    *pos += key_len;
+
+    if (json)
+    {
+        text_put_quoted(text, key, key_len);
+        text_put_char(text, ':');
+    }
+    else
+    {
+        text_put(text, key, key_len);
+        text_put_char(text, '=');
+    }
+
+    switch (type)
+    {
+        case ELOG_KV_U32:
+        case ELOG_KV_I32:
+        {
+            uint32_t value;
+            if (!unpack_bytes(payload, len, pos, &value, sizeof(value)))
+            {
+                return false;
+            }
+            if (type == ELOG_KV_I32)
+            {
+                text_put_i64(text, (int32_t)value);
+            }
+            else
+            {
+                text_put_u64(text, value);
+            }
+            break;
+        }
+        case ELOG_KV_U64:
+        case ELOG_KV_I64:
+        {
+            uint64_t value;
+            if (!unpack_bytes(payload, len, pos, &value, sizeof(value)))
+            {
+                return false;
+            }
+            if (type == ELOG_KV_I64)
+            {
+                text_put_i64(text, (int64_t)value);
+            }
+            else
+            {
+                text_put_u64(text, value);
+            }
+            break;
+        }
+        case ELOG_KV_F64:
+        {
+            double value;
+            char   number[32];
+            if (!unpack_bytes(payload, len, pos, &value, sizeof(value)))
+            {
+                return false;
+            }
+            /* JSON has no infinity or NaN */
+            if (json && (value != value || value - value != 0))
+            {
+                text_put(text, "null", 4);
+            }
+            else
+            {
+                int number_len = snprintf(number, sizeof(number), "%.15g", value);
+                text_put(text, number, (size_t)number_len);
+            }
+            break;
+        }
+        case ELOG_KV_BOOL:
+        {
+            uint8_t value;
+            if (!unpack_bytes(payload, len, pos, &value, sizeof(value)))
+            {
+                return false;
+            }
+            text_put(text, value ? "true" : "false", value ? 4 : 5);
+            break;
+        }
+        case ELOG_KV_STR:
+        {
+            uint16_t str_len;
+            if (!unpack_bytes(payload, len, pos, &str_len, sizeof(str_len)) || *pos + str_len > len)
+            {
+                return false;
+            }
+            text_put_str(text, payload + *pos, str_len, json);
+            *pos += str_len;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * render a structured record payload to text or JSON, the text always ends with a newline sign
+ * A field that doesn't fit is left out as a whole, so a JSON object stays valid.
+ *
+ * @param payload structured record payload
+ * @param len payload length
+ * @param out text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+size_t elog_kv_render (const char *payload, size_t len, char *out, size_t size)
+{
+    extern size_t elog_line_terminate(char *message, size_t log_len, size_t max_len);
+
+    bool      json        = __atomic_load_n(&kv_json, __ATOMIC_RELAXED);
+    size_t    newline_len = strlen(ELOG_NEWLINE_SIGN);
+    size_t    pos         = 0;
+    kv_text_t text        = {out, 0, 0, false};
+
+    /* room for the closing brace and the newline sign */
+    if (size < newline_len + 3)
+    {
+        return 0;
+    }
+    text.max_len = size - 1 - newline_len - (json ? 1 : 0);
+
+    if (json)
+    {
+        text_put_char(&text, '{');
+    }
+    for (bool first = true; pos < len; first = false)
+    {
+        size_t field_start = text.len;
+
+        if (!first)
+        {
+            text_put_char(&text, json ? ',' : ' ');
+        }
+        if (!render_field(&text, payload, len, &pos, json) || text.full)
+        {
+            text.len = field_start;
+            break;
+        }
+    }
+    if (json)
+    {
+        out[text.len++] = '}';
+    }
+
+    return elog_line_terminate(out, text.len, size - 1);
+}
+
+#endif /* ELOG_KV_ENABLE */
@@ -0,0 +1,419 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: LZ4 block compression and resyncable frames for the compressed drain output.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Frame layout, all fields little-endian:
+ *
+ *   | magic 0xE1 0x4C | flags | raw length u16 | data length u16 | header check | data CRC u16 | data |
+ *
+ * The data is an LZ4 block (token, literals, offset, match length), or the raw block when the flags say
+ * ELOG_LZ_FRAME_STORED because it didn't compress. The header check is the low byte of the CRC-16 of
+ * flags and lengths, so a reader can trust the lengths before the data arrived, and the data CRC-16 covers
+ * the data. A reader that lost bytes scans for the next magic with a valid header and data.
+ */
+
+#if defined(ELOG_ASYNC_COMPRESS_ENABLE)
+
+/* hash table entries of the compressor, 2 bytes each, it is static and only used by the drain */
+#ifndef ELOG_ASYNC_COMPRESS_HASH_BITS
+    #define ELOG_ASYNC_COMPRESS_HASH_BITS 9
+#endif /* ELOG_ASYNC_COMPRESS_HASH_BITS */
+
+#define FRAME_MAGIC_0 0xE1
+#define FRAME_MAGIC_1 0x4C
+#define FRAME_STORED  0x01
+
+/* LZ4 block format limits */
+#define MIN_MATCH     4
+#define MF_LIMIT      12 /* no match starts in the last MF_LIMIT bytes */
+#define LAST_LITERALS 5  /* the last LAST_LITERALS bytes are always literals */
+#define MAX_OFFSET    65535
+#define RUN_MASK      15
+
+static uint16_t hash_table[1 << ELOG_ASYNC_COMPRESS_HASH_BITS];
+
+/* CRC-16/CCITT-FALSE a nibble at a time */
+static const uint16_t crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static uint16_t crc16 (uint16_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = (uint16_t)(crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+
+    return crc;
+}
+
+static uint32_t read32 (const uint8_t *p)
+{
+    uint32_t value;
+
+    memcpy(&value, p, sizeof(value));
+
+    return value;
+}
+
+static uint32_t hash32 (uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - ELOG_ASYNC_COMPRESS_HASH_BITS);
+}
+
+/* bytes of the 255 run extension of a length field */
+static size_t length_ext_size (size_t len)
+{
+    return (len < RUN_MASK) ? 0 : (len - RUN_MASK) / 255 + 1;
+}
+
+static uint8_t *put_length_ext (uint8_t *op, size_t len)
+{
+    for (len -= RUN_MASK; len >= 255; len -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)len;
+
+    return op;
+}
+
+/* append a sequence, the match is left out when match_len is 0, NULL when it doesn't fit */
+static uint8_t *put_sequence (uint8_t *op, const uint8_t *op_end, const uint8_t *literals, size_t literal_len,
+                              size_t offset, size_t match_len)
+{
+    size_t size = 1 + length_ext_size(literal_len) + literal_len;
+    size_t code = 0;
+
+    if (match_len != 0)
+    {
+        code  = match_len - MIN_MATCH;
+        size += 2 + length_ext_size(code);
+    }
+    if (size > (size_t)(op_end - op))
+    {
+        return NULL;
+    }
+
+    uint8_t *token = op++;
+    *token = (uint8_t)(((literal_len < RUN_MASK) ? literal_len : RUN_MASK) << 4);
+    if (literal_len >= RUN_MASK)
+    {
+        op = put_length_ext(op, literal_len);
+    }
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    if (match_len != 0)
+    {
+        *op++   = (uint8_t)offset;
+        *op++   = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)((code < RUN_MASK) ? code : RUN_MASK);
+        if (code >= RUN_MASK)
+        {
+            op = put_length_ext(op, code);
+        }
+    }
+
+    return op;
+}
+
+/**
+ * Compress a block to the LZ4 block format with a greedy single probe hash match finder.
+ * It uses a static hash table, so it must only be called by one task at a time (the drain).
+ *
+ * @param src block
+ * @param size block size, up to 65535
+ * @param dst compressed block
+ * @param capacity dst size
+ *
+ * @return compressed size, 0 when it doesn't fit in capacity or the block is too large
+ */
+size_t elog_lz_compress (const char *src, size_t size, char *dst, size_t capacity)
+{
+    const uint8_t *base   = (const uint8_t *)src;
+    const uint8_t *ip     = base;
+    const uint8_t *anchor = base;
+    const uint8_t *end    = base + size;
+    uint8_t       *op     = (uint8_t *)dst;
+    uint8_t       *op_end = op + capacity;
+
+    if (size > MAX_OFFSET)
+    {
+        return 0;
+    }
+
+    if (size > MF_LIMIT)
+    {
+        const uint8_t *match_limit = end - MF_LIMIT;
+        const uint8_t *match_end   = end - LAST_LITERALS;
+
+        memset(hash_table, 0, sizeof(hash_table));
+        while (ip < match_limit)
+        {
+            size_t   pos = (size_t)(ip - base);
+            uint32_t h   = hash32(read32(ip));
+            size_t   ref = hash_table[h];
+
+            hash_table[h] = (uint16_t)pos;
+            if (ref >= pos || read32(base + ref) != read32(ip))
+            {
+                ip++;
+                continue;
+            }
+
+            const uint8_t *match = base + ref;
+            while (ip > anchor && match > base && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+            size_t match_len = MIN_MATCH;
+            while (ip + match_len < match_end && ip[match_len] == match[match_len])
+            {
+                match_len++;
+            }
+
+            op = put_sequence(op, op_end, anchor, (size_t)(ip - anchor), (size_t)(ip - match), match_len);
+            if (op == NULL)
+            {
+                return 0;
+            }
+            ip    += match_len;
+            anchor = ip;
+            /* the bytes in front of the next search position are a likely match for it */
+            hash_table[hash32(read32(ip - 2))] = (uint16_t)(ip - 2 - base);
+        }
+    }
+
+    op = put_sequence(op, op_end, anchor, (size_t)(end - anchor), 0, 0);
+    if (op == NULL)
+    {
+        return 0;
+    }
+
+    return (size_t)(op - (uint8_t *)dst);
+}
+
+/* read the 255 run extension of a length field */
+static bool get_length_ext (const uint8_t **ip, const uint8_t *end, size_t *len)
+{
+    uint8_t byte;
+
+    do
+    {
+        if (*ip >= end)
+        {
+            return false;
+        }
+        byte  = *(*ip)++;
+        *len += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+/**
+ * Decompress an LZ4 block, every length and offset is checked, so corrupted input is safe.
+ *
+ * @param src compressed block
+ * @param size compressed size
+ * @param dst block
+ * @param capacity dst size
+ *
+ * @return block size, 0 when the input is corrupted or the block doesn't fit in capacity
+ */
+size_t elog_lz_decompress (const char *src, size_t size, char *dst, size_t capacity)
+{
+    const uint8_t *ip     = (const uint8_t *)src;
+    const uint8_t *end    = ip + size;
+    uint8_t       *op     = (uint8_t *)dst;
+    uint8_t       *op_end = op + capacity;
+
+    while (ip < end)
+    {
+        uint8_t token       = *ip++;
+        size_t  literal_len = token >> 4;
+
+        if (literal_len == RUN_MASK && !get_length_ext(&ip, end, &literal_len))
+        {
+            return 0;
+        }
+        if (literal_len > (size_t)(end - ip) || literal_len > (size_t)(op_end - op))
+        {
+            return 0;
+        }
+        memcpy(op, ip, literal_len);
+        op += literal_len;
+        ip += literal_len;
+        if (ip == end)
+        {
+            break;
+        }
+
+        if (end - ip < 2)
+        {
+            return 0;
+        }
+        size_t offset    = ip[0] | ((size_t)ip[1] << 8);
+        size_t match_len = token & RUN_MASK;
+        ip += 2;
+        if (match_len == RUN_MASK && !get_length_ext(&ip, end, &match_len))
+        {
+            return 0;
+        }
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst) || match_len > (size_t)(op_end - op))
+        {
+            return 0;
+        }
+        /* the match may overlap the bytes it produces */
+        const uint8_t *match = op - offset;
+        for (size_t i = 0; i < match_len; i++)
+        {
+            op[i] = match[i];
+        }
+        op += match_len;
+    }
+
+    return (size_t)(op - (uint8_t *)dst);
+}
+
+/**
+ * Compress a block into a frame, it is stored raw when it doesn't compress.
+ *
+ * @param block block
+ * @param size block size, 1 to 65535
+ * @param frame frame
+ * @param capacity frame size, at least ELOG_LZ_FRAME_SIZE(size)
+ *
+ * @return frame size, 0 when the block size or capacity is out of range
+ */
+size_t elog_lz_frame_encode (const char *block, size_t size, char *frame, size_t capacity)
+{
+    uint8_t *out   = (uint8_t *)frame;
+    uint8_t  flags = 0;
+
+    if (size == 0 || size > MAX_OFFSET || capacity < ELOG_LZ_FRAME_SIZE(size))
+    {
+        return 0;
+    }
+
+    /* only keep the compressed block when it is smaller */
+    size_t data_len = elog_lz_compress(block, size, frame + ELOG_LZ_FRAME_HEADER_SIZE, size - 1);
+    if (data_len == 0)
+    {
+        flags    = FRAME_STORED;
+        data_len = size;
+        memcpy(out + ELOG_LZ_FRAME_HEADER_SIZE, block, size);
+    }
+
+    out[0] = FRAME_MAGIC_0;
+    out[1] = FRAME_MAGIC_1;
+    out[2] = flags;
+    out[3] = (uint8_t)size;
+    out[4] = (uint8_t)(size >> 8);
+    out[5] = (uint8_t)data_len;
+    out[6] = (uint8_t)(data_len >> 8);
+    out[7] = (uint8_t)crc16(0xFFFF, out + 2, 5);
+    uint16_t crc = crc16(0xFFFF, out + ELOG_LZ_FRAME_HEADER_SIZE, data_len);
+    out[8] = (uint8_t)crc;
+    out[9] = (uint8_t)(crc >> 8);
+
+    return ELOG_LZ_FRAME_HEADER_SIZE + data_len;
+}
+
+/**
+ * Decode the first valid frame of a stream. Bytes in front of it that don't start a valid frame (lost or
+ * corrupted frames) are skipped. When the stream ends in the middle of a frame, the rest is not consumed,
+ * so it can be decoded again with the following bytes appended.
+ *
+ * @param stream stream
+ * @param size stream size
+ * @param consumed stream bytes used and skipped
+ * @param block decoded block
+ * @param capacity block size, frames with larger blocks are skipped
+ *
+ * @return block size, 0 when there is no complete frame
+ */
+size_t elog_lz_frame_decode (const char *stream, size_t size, size_t *consumed, char *block, size_t capacity)
+{
+    const uint8_t *in  = (const uint8_t *)stream;
+    size_t         pos = 0;
+
+    for (; size - pos >= ELOG_LZ_FRAME_HEADER_SIZE; pos++)
+    {
+        const uint8_t *p = in + pos;
+
+        if (p[0] != FRAME_MAGIC_0 || p[1] != FRAME_MAGIC_1 || p[7] != (uint8_t)crc16(0xFFFF, p + 2, 5))
+        {
+            continue;
+        }
+
+        uint8_t flags    = p[2];
+        size_t  raw_len  = p[3] | ((size_t)p[4] << 8);
+        size_t  data_len = p[5] | ((size_t)p[6] << 8);
+        if ((flags & ~FRAME_STORED) != 0 || raw_len == 0 || raw_len > capacity
+            || ((flags & FRAME_STORED) ? data_len != raw_len : data_len >= raw_len))
+        {
+            continue;
+        }
+        if (size - pos - ELOG_LZ_FRAME_HEADER_SIZE < data_len)
+        {
+            break;
+        }
+
+        const char *data = stream + pos + ELOG_LZ_FRAME_HEADER_SIZE;
+        if (crc16(0xFFFF, (const uint8_t *)data, data_len) != (p[8] | (p[9] << 8)))
+        {
+            continue;
+        }
+        if (flags & FRAME_STORED)
+        {
+            memcpy(block, data, raw_len);
+        }
+        else if (elog_lz_decompress(data, data_len, block, capacity) != raw_len)
+        {
+            continue;
+        }
+
+        *consumed = pos + ELOG_LZ_FRAME_HEADER_SIZE + data_len;
+        return raw_len;
+    }
+
+    *consumed = pos;
+    return 0;
+}
+
+#endif /* ELOG_ASYNC_COMPRESS_ENABLE */
@@ -0,0 +1,796 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Built-in vsnprintf subset for the log messages, no locale, no heap and no reentrancy struct.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ELOG_PRINTF_ENABLE)
+
+#if defined(ELOG_PRINTF_LIBC_FALLBACK)
+    #include <stdio.h>
+#endif
+
+/*
+ * Supported: %d %i %u %x %X %o %c %s %p %% with the flags "-+ #0", width and precision (also '*') and
+ * the length modifiers hh h l ll j z t. %f %F need ELOG_PRINTF_FLOAT_ENABLE, they print 17 fraction digits
+ * at most and zeros after them (libc prints the exact binary fraction). The other conversions
+ * (%e %g %a and %f without float support) go to the libc vsnprintf with ELOG_PRINTF_LIBC_FALLBACK,
+ * otherwise their specification is output as it is and the arg is skipped. %n writes nothing.
+ */
+
+/* flags */
+#define FLAG_LEFT  (1 << 0) /* '-' */
+#define FLAG_PLUS  (1 << 1) /* '+' */
+#define FLAG_SPACE (1 << 2) /* ' ' */
+#define FLAG_ALT   (1 << 3) /* '#' */
+#define FLAG_ZERO  (1 << 4) /* '0' */
+#define FLAG_UPPER (1 << 5) /* upper case hex digits */
+
+/* the longest integer text, 64 bit octal */
+#define INT_TEXT_LEN 22
+
+typedef struct
+{
+    char  *buf;
+    size_t size;
+    size_t len; /* may pass the size, it's the length the text would have */
+} out_t;
+
+typedef enum
+{
+    LEN_NONE,
+    LEN_HH,
+    LEN_H,
+    LEN_L,
+    LEN_LL,
+    LEN_J,
+    LEN_Z,
+    LEN_T,
+    LEN_LD, /* 'L' */
+} len_mod_t;
+
+typedef struct
+{
+    unsigned  flags;
+    int       width;     /* 0: none */
+    int       precision; /* -1: none */
+    len_mod_t length;
+} spec_t;
+
+extern const char elog_digit_pairs[];
+
+static const char hex_digits[] = "0123456789abcdef0123456789ABCDEF";
+
+static void out_mem (out_t *out, const char *mem, size_t n)
+{
+    if (out->len < out->size)
+    {
+        size_t room = out->size - out->len;
+        memcpy(out->buf + out->len, mem, (n < room) ? n : room);
+    }
+    out->len += n;
+}
+
+static void out_fill (out_t *out, char c, size_t n)
+{
+    if (out->len < out->size)
+    {
+        size_t room = out->size - out->len;
+        memset(out->buf + out->len, c, (n < room) ? n : room);
+    }
+    out->len += n;
+}
+
+/**
+ * convert an unsigned integer to text, decimal goes two digits per step and in 32 bit once it fits
+ *
+ * @param end end of the text buffer, the text is written backwards in front of it
+ * @param value integer
+ * @param base 8, 10 or 16
+ * @param upper upper case hex digits
+ *
+ * @return text start
+ */
+static char *format_uint (char *end, uint64_t value, unsigned base, bool upper)
+{
+    char *p = end;
+
+    if (base == 10)
+    {
+        while (value > UINT32_MAX)
+        {
+            p -= 2;
+            memcpy(p, &elog_digit_pairs[(value % 100) * 2], 2);
+            value /= 100;
+        }
+        uint32_t value32 = (uint32_t)value;
+        while (value32 >= 100)
+        {
+            p -= 2;
+            memcpy(p, &elog_digit_pairs[(value32 % 100) * 2], 2);
+            value32 /= 100;
+        }
+        if (value32 >= 10)
+        {
+            p -= 2;
+            memcpy(p, &elog_digit_pairs[value32 * 2], 2);
+        }
+        else
+        {
+            *--p = (char)('0' + value32);
+        }
+    }
+    else
+    {
+        unsigned shift = (base == 16) ? 4 : 3;
+        const char *digits = hex_digits + (upper ? 16 : 0);
+
+        do
+        {
+            *--p = digits[value & (base - 1)];
+            value >>= shift;
+        } while (value != 0);
+    }
+
+    return p;
+}
+
+/**
+ * output a field padded to the width, the zero padding goes between the prefix and the body
+ *
+ * @param out output
+ * @param spec specification, width and flags
+ * @param prefix sign and base prefix
+ * @param prefix_len prefix length
+ * @param zeros leading zeros of the body (integer precision)
+ * @param body body text
+ * @param body_len body length
+ */
+static void out_field (out_t *out, const spec_t *spec, const char *prefix, size_t prefix_len, size_t zeros,
+                       const char *body, size_t body_len)
+{
+    size_t len = prefix_len + zeros + body_len;
+    size_t pad = (spec->width > 0 && (size_t)spec->width > len) ? (size_t)spec->width - len : 0;
+
+    if (!(spec->flags & FLAG_LEFT) && !(spec->flags & FLAG_ZERO))
+    {
+        out_fill(out, ' ', pad);
+    }
+    out_mem(out, prefix, prefix_len);
+    if (!(spec->flags & FLAG_LEFT) && (spec->flags & FLAG_ZERO))
+    {
+        out_fill(out, '0', pad);
+    }
+    out_fill(out, '0', zeros);
+    out_mem(out, body, body_len);
+    if (spec->flags & FLAG_LEFT)
+    {
+        out_fill(out, ' ', pad);
+    }
+}
+
+/**
+ * output an integer conversion
+ *
+ * @param out output
+ * @param spec specification
+ * @param value magnitude
+ * @param negative the value is negative
+ * @param conversion conversion character
+ */
+static void out_int (out_t *out, const spec_t *spec, uint64_t value, bool negative, char conversion)
+{
+    char     text[INT_TEXT_LEN];
+    char     prefix[3];
+    size_t   prefix_len = 0;
+    unsigned base       = (conversion == 'o') ? 8 : (conversion == 'x' || conversion == 'X' || conversion == 'p') ? 16 : 10;
+    char    *body       = text + sizeof(text);
+    size_t   body_len   = 0;
+    size_t   zeros      = 0;
+    spec_t   field      = *spec;
+
+    /* the integer precision replaces the zero padding */
+    if (field.precision >= 0)
+    {
+        field.flags &= ~FLAG_ZERO;
+    }
+
+    if (negative)
+    {
+        prefix[prefix_len++] = '-';
+    }
+    else if (conversion == 'd' || conversion == 'i')
+    {
+        if (spec->flags & FLAG_PLUS)
+        {
+            prefix[prefix_len++] = '+';
+        }
+        else if (spec->flags & FLAG_SPACE)
+        {
+            prefix[prefix_len++] = ' ';
+        }
+    }
+
+    /* precision 0 prints no digit for 0 */
+    if (value != 0 || spec->precision != 0)
+    {
+        body     = format_uint(text + sizeof(text), value, base, conversion == 'X');
+        body_len = (size_t)(text + sizeof(text) - body);
+    }
+    if (spec->precision > 0 && (size_t)spec->precision > body_len)
+    {
+        zeros = (size_t)spec->precision - body_len;
+    }
+
+    if ((spec->flags & FLAG_ALT) || conversion == 'p')
+    {
+        if (base == 16 && (value != 0 || conversion == 'p'))
+        {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = (conversion == 'X') ? 'X' : 'x';
+        }
+        else if (base == 8 && zeros == 0 && (body_len == 0 || *body != '0'))
+        {
+            zeros = 1;
+        }
+    }
+
+    out_field(out, &field, prefix, prefix_len, zeros, body, body_len);
+}
+
+#if defined(ELOG_PRINTF_FLOAT_ENABLE)
+/* fraction digits that are computed, the precision past them is zeros */
+#define FLOAT_DIGITS_MAX 17
+/* integer part text of the largest double */
+#define FLOAT_INT_TEXT_LEN 310
+/* base of the limbs of a huge integer part */
+#define LIMB_BASE 1000000000U
+
+/**
+ * exact product of two doubles as the sum of the rounded product and its error (Dekker), so the
+ * fraction digits round like libc without needing fma
+ *
+ * @param a factor
+ * @param b factor
+ * @param product rounded product
+ * @param error product error
+ */
+static void two_product (double a, double b, double *product, double *error)
+{
+    const double split = 134217729.0; /* 2^27 + 1 */
+    double       c = split * a, a_high = c - (c - a), a_low = a - a_high;
+    double       d = split * b, b_high = d - (d - b), b_low = b - b_high;
+
+    *product = a * b;
+    *error   = ((a_high * b_high - *product) + a_high * b_low + a_low * b_high) + a_low * b_low;
+}
+
+/**
+ * convert an integral double of 2^64 or more to decimal text, exactly
+ * Its IEEE 754 mantissa is shifted up by the exponent in base 10^9 limbs.
+ *
+ * @param end end of the text buffer, FLOAT_INT_TEXT_LEN, the text is written backwards in front of it
+ * @param value integral value
+ *
+ * @return text start
+ */
+static char *format_huge (char *end, double value)
+{
+    uint32_t limbs[(FLOAT_INT_TEXT_LEN + 8) / 9];
+    size_t   count = 0;
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    int      exponent = (int)((bits >> 52) & 0x7FF) - 1075;
+    uint64_t mantissa = (bits & ((1ULL << 52) - 1)) | (1ULL << 52);
+
+    while (mantissa != 0)
+    {
+        limbs[count++] = (uint32_t)(mantissa % LIMB_BASE);
+        mantissa /= LIMB_BASE;
+    }
+    while (exponent > 0)
+    {
+        int      shift = (exponent > 29) ? 29 : exponent;
+        uint64_t carry = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t limb = ((uint64_t)limbs[i] << shift) + carry;
+            limbs[i]      = (uint32_t)(limb % LIMB_BASE);
+            carry         = limb / LIMB_BASE;
+        }
+        for (; carry != 0; carry /= LIMB_BASE)
+        {
+            limbs[count++] = (uint32_t)(carry % LIMB_BASE);
+        }
+        exponent -= shift;
+    }
+
+    char *p = end;
+    for (size_t i = 0; i < count - 1; i++)
+    {
+        char *limb_end = p;
+        p              = format_uint(p, limbs[i], 10, false);
+        while (p > limb_end - 9)
+        {
+            *--p = '0';
+        }
+    }
+    return format_uint(p, limbs[count - 1], 10, false);
+}
+
+/**
+ * output a %f conversion, the fraction digits past FLOAT_DIGITS_MAX are zeros
+ *
+ * @param out output
+ * @param spec specification
+ * @param value value
+ * @param upper %F
+ */
+static void out_float (out_t *out, const spec_t *spec, double value, bool upper)
+{
+    static const uint64_t pow10[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+                                     10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+                                     100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                                     100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                                     100000000000000000ULL};
+    char   text[FLOAT_INT_TEXT_LEN + 1 + FLOAT_DIGITS_MAX];
+    char  *end        = text + sizeof(text);
+    char  *p          = end;
+    char   prefix[1];
+    size_t prefix_len = 0;
+    int    precision  = (spec->precision < 0) ? 6 : spec->precision;
+    int    digits     = (precision < FLOAT_DIGITS_MAX) ? precision : FLOAT_DIGITS_MAX;
+
+    if (signbit(value))
+    {
+        prefix[prefix_len++] = '-';
+        value                = -value;
+    }
+    else if (spec->flags & FLAG_PLUS)
+    {
+        prefix[prefix_len++] = '+';
+    }
+    else if (spec->flags & FLAG_SPACE)
+    {
+        prefix[prefix_len++] = ' ';
+    }
+
+    if (!isfinite(value))
+    {
+        spec_t field = *spec;
+
+        field.flags &= ~FLAG_ZERO;
+        out_field(out, &field, prefix, prefix_len, 0, isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf"),
+                  3);
+        return;
+    }
+
+    if (value >= 18446744073709551616.0)
+    {
+        /* 2^64 or more is integral */
+        if (precision > 0 || (spec->flags & FLAG_ALT))
+        {
+            p -= digits;
+            memset(p, '0', (size_t)digits);
+            *--p = '.';
+        }
+        p = format_huge(p, value);
+    }
+    else
+    {
+        uint64_t integer = (uint64_t)value;
+        double   scaled, error;
+
+        two_product(value - (double)integer, (double)pow10[digits], &scaled, &error);
+        uint64_t fraction = (uint64_t)scaled;
+        double   rest     = scaled - (double)fraction;
+
+        /* the error passes whole units above 2^53, where the rest is zero */
+        int64_t carry = (int64_t)error;
+        fraction += (uint64_t)carry;
+        error -= (double)carry;
+        if (rest == 0 && error < 0)
+        {
+            fraction--;
+            rest = 1.0;
+        }
+        /* round half to even on rest + error, the sign of the sum is exact */
+        double half = (rest - 0.5) + error;
+        if (half > 0 || (half == 0 && ((digits > 0) ? fraction : integer) & 1))
+        {
+            fraction++;
+        }
+        if (fraction >= pow10[digits])
+        {
+            fraction -= pow10[digits];
+            integer++;
+        }
+
+        if (precision > 0 || (spec->flags & FLAG_ALT))
+        {
+            for (int i = 0; i < digits; i++)
+            {
+                *--p = (char)('0' + fraction % 10);
+                fraction /= 10;
+            }
+            *--p = '.';
+        }
+        p = format_uint(p, integer, 10, false);
+    }
+
+    /* the body and the precision past FLOAT_DIGITS_MAX */
+    size_t body_len = (size_t)(end - p);
+    size_t extra    = (size_t)(precision - digits);
+    size_t len      = prefix_len + body_len + extra;
+    size_t pad      = (spec->width > 0 && (size_t)spec->width > len) ? (size_t)spec->width - len : 0;
+
+    if (!(spec->flags & FLAG_LEFT) && !(spec->flags & FLAG_ZERO))
+    {
+        out_fill(out, ' ', pad);
+    }
+    out_mem(out, prefix, prefix_len);
+    if (!(spec->flags & FLAG_LEFT) && (spec->flags & FLAG_ZERO))
+    {
+        out_fill(out, '0', pad);
+    }
+    out_mem(out, p, body_len);
+    out_fill(out, '0', extra);
+    if (spec->flags & FLAG_LEFT)
+    {
+        out_fill(out, ' ', pad);
+    }
+}
+#endif /* ELOG_PRINTF_FLOAT_ENABLE */
+
+/**
+ * fetch a signed integer arg of the length modifier
+ *
+ * @return arg
+ */
+static int64_t arg_int (va_list *args, len_mod_t length)
+{
+    switch (length)
+    {
+    case LEN_HH: return (signed char)va_arg(*args, int);
+    case LEN_H: return (short)va_arg(*args, int);
+    case LEN_L: return va_arg(*args, long);
+    case LEN_LL: return va_arg(*args, long long);
+    case LEN_J: return va_arg(*args, intmax_t);
+    case LEN_Z: return va_arg(*args, ptrdiff_t); /* signed size_t */
+    case LEN_T: return va_arg(*args, ptrdiff_t);
+    default: return va_arg(*args, int);
+    }
+}
+
+/**
+ * fetch an unsigned integer arg of the length modifier
+ *
+ * @return arg
+ */
+static uint64_t arg_uint (va_list *args, len_mod_t length)
+{
+    switch (length)
+    {
+    case LEN_HH: return (unsigned char)va_arg(*args, unsigned int);
+    case LEN_H: return (unsigned short)va_arg(*args, unsigned int);
+    case LEN_L: return va_arg(*args, unsigned long);
+    case LEN_LL: return va_arg(*args, unsigned long long);
+    case LEN_J: return va_arg(*args, uintmax_t);
+    case LEN_Z: return va_arg(*args, size_t);
+    case LEN_T: return (uint64_t)va_arg(*args, ptrdiff_t);
+    default: return va_arg(*args, unsigned int);
+    }
+}
+
+/**
+ * parse the flags, width, precision and length of a conversion specification
+ *
+ * @param p format position right behind the '%'
+ * @param spec parsed specification
+ * @param args args, for '*' width and precision
+ *
+ * @return format position of the conversion character
+ */
+static const char *parse_spec (const char *p, spec_t *spec, va_list *args)
+{
+    spec->flags     = 0;
+    spec->width     = 0;
+    spec->precision = -1;
+    spec->length    = LEN_NONE;
+
+    for (;; p++)
+    {
+        if (*p == '-')
+            spec->flags |= FLAG_LEFT;
+        else if (*p == '+')
+            spec->flags |= FLAG_PLUS;
+        else if (*p == ' ')
+            spec->flags |= FLAG_SPACE;
+        else if (*p == '#')
+            spec->flags |= FLAG_ALT;
+        else if (*p == '0')
+            spec->flags |= FLAG_ZERO;
+        else
+            break;
+    }
+
+    if (*p == '*')
+    {
+        spec->width = va_arg(*args, int);
+        if (spec->width < 0)
+        {
+            spec->flags |= FLAG_LEFT;
+            spec->width = -spec->width;
+        }
+        p++;
+    }
+    else
+    {
+        for (; *p >= '0' && *p <= '9'; p++)
+        {
+            spec->width = spec->width * 10 + (*p - '0');
+        }
+    }
+
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            spec->precision = va_arg(*args, int);
+            if (spec->precision < 0)
+            {
+                spec->precision = -1;
+            }
+            p++;
+        }
+        else
+        {
+            for (spec->precision = 0; *p >= '0' && *p <= '9'; p++)
+            {
+                spec->precision = spec->precision * 10 + (*p - '0');
+            }
+        }
+    }
+
+    switch (*p)
+    {
+    case 'h':
+        spec->length = (p[1] == 'h') ? LEN_HH : LEN_H;
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        spec->length = (p[1] == 'l') ? LEN_LL : LEN_L;
+        p += (p[1] == 'l') ? 2 : 1;
+        break;
+    case 'j':
+        spec->length = LEN_J;
+        p++;
+        break;
+    case 'z':
+        spec->length = LEN_Z;
+        p++;
+        break;
+    case 't':
+        spec->length = LEN_T;
+        p++;
+        break;
+    case 'L':
+        spec->length = LEN_LD;
+        p++;
+        break;
+    default:
+        break;
+    }
+
+    return p;
+}
+
+/**
+ * format like vsnprintf with the supported conversions
+ *
+ * @param buf text buffer
+ * @param size text buffer size, the text is cut to size - 1 and always terminated unless size is 0
+ * @param format format
+ * @param args args
+ *
+ * @return length of the whole text, even when it was cut
+ */
+int elog_vsnprintf (char *buf, size_t size, const char *format, va_list args)
+{
+    out_t   out = {buf, size, 0};
+    va_list ap;
+
+#if defined(ELOG_PRINTF_LIBC_FALLBACK)
+    const char *format_start = format;
+    va_list     fallback_args;
+    va_copy(fallback_args, args);
+#endif
+    va_copy(ap, args);
+
+    while (*format)
+    {
+        const char *start = format;
+        spec_t      spec;
+
+        while (*format && *format != '%')
+        {
+            format++;
+        }
+        out_mem(&out, start, (size_t)(format - start));
+        if (*format == '\0')
+        {
+            break;
+        }
+
+        start  = format;
+        format = parse_spec(format + 1, &spec, &ap);
+
+        switch (*format)
+        {
+        case 'd':
+        case 'i':
+        {
+            int64_t value = arg_int(&ap, spec.length);
+            out_int(&out, &spec, (value < 0) ? 0 - (uint64_t)value : (uint64_t)value, value < 0, *format);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            out_int(&out, &spec, arg_uint(&ap, spec.length), false, *format);
+            break;
+        case 'p':
+            out_int(&out, &spec, (uintptr_t)va_arg(ap, void *), false, 'p');
+            break;
+        case 'c':
+        {
+            char c = (char)va_arg(ap, int);
+            spec.flags &= ~FLAG_ZERO;
+            out_field(&out, &spec, NULL, 0, 0, &c, 1);
+            break;
+        }
+        case 's':
+        {
+            const char *s   = va_arg(ap, const char *);
+            size_t      len = 0;
+
+            if (s == NULL)
+            {
+                s = "(null)";
+            }
+            while (s[len] != '\0' && (spec.precision < 0 || len < (size_t)spec.precision))
+            {
+                len++;
+            }
+            spec.flags &= ~FLAG_ZERO;
+            out_field(&out, &spec, NULL, 0, 0, s, len);
+            break;
+        }
+        case '%':
+            out_mem(&out, "%", 1);
+            break;
+        case 'n':
+            /* nothing is written back */
+            (void)va_arg(ap, void *);
+            break;
+#if defined(ELOG_PRINTF_FLOAT_ENABLE)
+        case 'f':
+        case 'F':
+        {
+            double value = (spec.length == LEN_LD) ? (double)va_arg(ap, long double) : va_arg(ap, double);
+            out_float(&out, &spec, value, *format == 'F');
+            break;
+        }
+#endif /* ELOG_PRINTF_FLOAT_ENABLE */
+#if !defined(ELOG_PRINTF_FLOAT_ENABLE)
+        case 'f':
+        case 'F':
+#endif
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+#if defined(ELOG_PRINTF_LIBC_FALLBACK)
+        {
+            int result;
+
+            va_end(ap);
+            result = vsnprintf(buf, size, format_start, fallback_args);
+            va_end(fallback_args);
+            return result;
+        }
+#else
+            if (spec.length == LEN_LD)
+            {
+                (void)va_arg(ap, long double);
+            }
+            else
+            {
+                (void)va_arg(ap, double);
+            }
+            out_mem(&out, start, (size_t)(format + 1 - start));
+            break;
+#endif /* ELOG_PRINTF_LIBC_FALLBACK */
+        default:
+            /* not a conversion, output it as it is */
+            out_mem(&out, start, (size_t)(format - start));
+            if (*format == '\0')
+            {
+                continue;
+            }
+            out_mem(&out, format, 1);
+            break;
+        }
+        format++;
+    }
+    va_end(ap);
+#if defined(ELOG_PRINTF_LIBC_FALLBACK)
+    va_end(fallback_args);
+#endif
+
+    if (size > 0)
+    {
+        buf[(out.len < size) ? out.len : size - 1] = '\0';
+    }
+
+    return (int)out.len;
+}
+
+/**
+ * format like snprintf with the supported conversions
+ *
+ * @param buf text buffer
+ * @param size text buffer size
+ * @param format format
+ * @param ... args
+ *
+ * @return length of the whole text, even when it was cut
+ */
+int elog_snprintf (char *buf, size_t size, const char *format, ...)
+{
+    va_list args;
+    int     result;
+
+    va_start(args, format);
+    result = elog_vsnprintf(buf, size, format, args);
+    va_end(args);
+
+    return result;
+}
+
+#endif /* ELOG_PRINTF_ENABLE */
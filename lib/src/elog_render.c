@@ -0,0 +1,430 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Renders log records to text lines with the format set of their level.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/*
+ * Line layout, every field is optional:
+ *
+ *   2026-10-17 12:00:00.123 #42 [Info] tag (file:func:line): message
+ *
+ * The level text and the format set are kept in a template per level, and the date and time text
+ * of the last second is cached, so a line is mostly memcpy. Integers go through a digit pair table.
+ */
+
+/* longest level text in a template, level_output_info is cut to it */
+#define LEVEL_MAX_LEN 15
+/* longest date and time text from elog_port_fmt_time */
+#define TIME_MAX_LEN  32
+
+typedef struct
+{
+    size_t set;
+    size_t level_len;
+    char   level[LEVEL_MAX_LEN + 1];
+} render_template_t;
+
+/* date and time text of one second, it's only used by one renderer at a time */
+typedef struct
+{
+    atomic_flag busy;
+    bool        valid;
+    uint64_t    start; /* first tick of the second */
+    size_t      len;
+    char        text[TIME_MAX_LEN];
+} time_cache_t;
+
+/* line under construction, appends past the end are cut */
+typedef struct
+{
+    char  *buf;
+    size_t len;
+    size_t size;
+} render_line_t;
+
+/* two decimal digits of 0 to 99, shared with elog_printf.c */
+const char elog_digit_pairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+
+extern const char *level_output_info[];
+
+/*
+ * Two templates per level, elog_set_fmt may change a level while the drain renders it. The writer fills
+ * the slot that isn't published and publishes it by counting up the generation, the slot is its low bit.
+ * A renderer copies the published template and takes it when the generation didn't change meanwhile.
+ */
+static render_template_t templates[ELOG_LVL_TOTAL_NUM][2];
+static atomic_uint       template_gen[ELOG_LVL_TOTAL_NUM];
+static atomic_flag       template_busy = ATOMIC_FLAG_INIT;
+static time_cache_t      time_cache    = {.busy = ATOMIC_FLAG_INIT};
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/* counter to wall time conversion of the rendered records, the drain takes the calibration records */
+static elog_calib_t      render_calib;
+#endif
+
+/**
+ * convert an integer to decimal text, two digits per step
+ *
+ * @param text text buffer, at least 10 characters
+ * @param value integer
+ *
+ * @return text length
+ */
+static size_t render_u32 (char *text, uint32_t value)
+{
+    char  digits[10];
+    char *p = digits + sizeof(digits);
+
+    while (value >= 100)
+    {
+        p -= 2;
+        memcpy(p, &elog_digit_pairs[(value % 100) * 2], 2);
+        value /= 100;
+    }
+    if (value >= 10)
+    {
+        p -= 2;
+        memcpy(p, &elog_digit_pairs[value * 2], 2);
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+
+    size_t len = (size_t)(digits + sizeof(digits) - p);
+    memcpy(text, p, len);
+    return len;
+}
+
+/**
+ * append text to the line
+ *
+ * @param line line
+ * @param text text
+ * @param len text length
+ */
+static void line_put (render_line_t *line, const char *text, size_t len)
+{
+    size_t room = line->size - line->len;
+
+    if (len > room)
+    {
+        len = room;
+    }
+    memcpy(line->buf + line->len, text, len);
+    line->len += len;
+}
+
+/**
+ * append an integer as decimal text to the line
+ *
+ * @param line line
+ * @param value integer
+ */
+static void line_put_u32 (render_line_t *line, uint32_t value)
+{
+    char text[10];
+
+    line_put(line, text, render_u32(text, value));
+}
+
+/**
+ * date and time text port interface, the default is the number of seconds
+ * A port with a calendar clock can replace it with e.g. "YYYY-MM-DD HH:MM:SS", it is called once per second.
+ *
+ * @param sec timestamp seconds
+ * @param text text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+__attribute__((weak)) size_t elog_port_fmt_time (uint64_t sec, char *text, size_t size)
+{
+    char digits[10];
+    size_t len = render_u32(digits, (uint32_t)sec);
+
+    if (len > size)
+    {
+        len = size;
+    }
+    memcpy(text, digits, len);
+    return len;
+}
+
+/**
+ * append the timestamp, the date and time text of the cached second and three digits of milliseconds
+ *
+ * @param line line
+ * @param timestamp timestamp in elog_port_get_time ticks
+ */
+static void line_put_time (render_line_t *line, elog_timestamp_t timestamp)
+{
+    uint64_t ticks = (uint64_t)timestamp.high << 32 | timestamp.low;
+    uint32_t sub;
+
+    if (!atomic_flag_test_and_set_explicit(&time_cache.busy, memory_order_acquire))
+    {
+        if (!time_cache.valid || ticks - time_cache.start >= ELOG_FMT_TIME_FREQ)
+        {
+            uint64_t sec     = ticks / ELOG_FMT_TIME_FREQ;
+            time_cache.start = sec * ELOG_FMT_TIME_FREQ;
+            time_cache.len   = elog_port_fmt_time(sec, time_cache.text, sizeof(time_cache.text));
+            time_cache.valid = true;
+        }
+        sub = (uint32_t)(ticks - time_cache.start);
+        line_put(line, time_cache.text, time_cache.len);
+        atomic_flag_clear_explicit(&time_cache.busy, memory_order_release);
+    }
+    else
+    {
+        /* another renderer (the drain and a direct output) has the cache */
+        char     text[TIME_MAX_LEN];
+        uint64_t sec = ticks / ELOG_FMT_TIME_FREQ;
+
+        sub = (uint32_t)(ticks - sec * ELOG_FMT_TIME_FREQ);
+        line_put(line, text, elog_port_fmt_time(sec, text, sizeof(text)));
+    }
+
+    uint32_t ms = (uint32_t)((uint64_t)sub * 1000 / ELOG_FMT_TIME_FREQ);
+    char     text[4] = {'.', (char)('0' + ms / 100), elog_digit_pairs[(ms % 100) * 2], elog_digit_pairs[(ms % 100) * 2 + 1]};
+    line_put(line, text, sizeof(text));
+}
+
+/**
+ * set the format set of a level template, the logs rendered meanwhile get the old or the new one
+ *
+ * @param level level
+ * @param set format set, ElogFmtIndex bits
+ */
+void elog_render_set_fmt (uint8_t level, size_t set)
+{
+    render_template_t *template;
+    unsigned int       gen;
+    size_t             len = 0;
+
+    while (atomic_flag_test_and_set_explicit(&template_busy, memory_order_acquire))
+    {
+    }
+    gen      = atomic_load_explicit(&template_gen[level], memory_order_relaxed);
+    template = &templates[level][(gen + 1) & 1];
+    /* the slot was published two generations ago, a renderer that still copies it sees the last one change */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (set & ELOG_FMT_LVL)
+    {
+        len = strlen(level_output_info[level]);
+        if (len > LEVEL_MAX_LEN - 1)
+        {
+            len = LEVEL_MAX_LEN - 1;
+        }
+        memcpy(template->level, level_output_info[level], len);
+        template->level[len++] = ' ';
+    }
+    template->level_len = len;
+    template->set       = set;
+
+    atomic_store_explicit(&template_gen[level], gen + 1, memory_order_release);
+    atomic_flag_clear_explicit(&template_busy, memory_order_release);
+}
+
+/**
+ * copy the published template of a level
+ *
+ * @param level level
+ * @param template template copy
+ */
+static void template_get (uint8_t level, render_template_t *template)
+{
+    unsigned int gen = atomic_load_explicit(&template_gen[level], memory_order_acquire);
+
+    for (;;)
+    {
+        unsigned int check;
+
+        *template = templates[level][gen & 1];
+        atomic_thread_fence(memory_order_acquire);
+        check = atomic_load_explicit(&template_gen[level], memory_order_acquire);
+        if (check == gen)
+        {
+            return;
+        }
+        gen = check;
+    }
+}
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/**
+ * take a calibration record, the records behind it are rendered with the wall time it gives
+ * elog_render takes them by itself, a port rendering with elog_render_prefix calls it for ELOG_RECORD_CALIB.
+ *
+ * @param record calibration record, header and message
+ */
+void elog_render_calibrate (const char *record)
+{
+    elog_calib_update(&render_calib, record);
+}
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+
+/**
+ * render the prefix of a log record with the format set of its level
+ *
+ * @param header record header
+ * @param prefix prefix buffer
+ * @param size prefix buffer size, the prefix is cut to it
+ *
+ * @return prefix length, there is no terminating zero
+ */
+size_t elog_render_prefix (const elog_header_t *header, char *prefix, size_t size)
+{
+    render_line_t      line = {prefix, 0, size};
+    render_template_t  template;
+    const elog_site_t *site = NULL;
+    size_t             set;
+
+    template_get((header->level < ELOG_LVL_TOTAL_NUM) ? header->level : 0, &template);
+    set = template.set;
+
+    if (set & (ELOG_FMT_TAG | ELOG_FMT_DIR | ELOG_FMT_FUNC | ELOG_FMT_LINE))
+    {
+        site = elog_find_site(header->site_id);
+    }
+
+    if (set & ELOG_FMT_TIME)
+    {
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+        line_put_time(&line, elog_calib_time(&render_calib, header->timestamp));
+#else
+        line_put_time(&line, header->timestamp);
+#endif
+        line_put(&line, " ", 1);
+    }
+    if (set & ELOG_FMT_SEQ)
+    {
+        line_put(&line, "#", 1);
+        line_put_u32(&line, header->seq_num);
+        line_put(&line, " ", 1);
+    }
+    line_put(&line, template.level, template.level_len);
+    if (site == NULL)
+    {
+        return line.len;
+    }
+
+    if (set & ELOG_FMT_TAG)
+    {
+        line_put(&line, site->tag, strlen(site->tag));
+    }
+    if (set & (ELOG_FMT_DIR | ELOG_FMT_FUNC | ELOG_FMT_LINE))
+    {
+        const char *separator = "(";
+
+        if (set & ELOG_FMT_TAG)
+        {
+            line_put(&line, " ", 1);
+        }
+        if (set & ELOG_FMT_DIR)
+        {
+            line_put(&line, separator, 1);
+            line_put(&line, site->file, strlen(site->file));
+            separator = ":";
+        }
+        if (set & ELOG_FMT_FUNC)
+        {
+            line_put(&line, separator, 1);
+            line_put(&line, site->func, strlen(site->func));
+            separator = ":";
+        }
+        if (set & ELOG_FMT_LINE)
+        {
+            line_put(&line, separator, 1);
+            line_put_u32(&line, (uint32_t)site->line);
+        }
+        line_put(&line, ")", 1);
+    }
+    if (set & (ELOG_FMT_TAG | ELOG_FMT_DIR | ELOG_FMT_FUNC | ELOG_FMT_LINE))
+    {
+        line_put(&line, ": ", 2);
+    }
+
+    return line.len;
+}
+
+/**
+ * render a text log record (header and message) to a text line
+ * Deferred records are rendered to text records on the drain before they get to the port. A calibration
+ * record (ELOG_TIME_COUNTER_ENABLE) is taken and has no line.
+ *
+ * @param record log record
+ * @param size log record size
+ * @param line line buffer
+ * @param line_size line buffer size, a longer message is cut and still ends with the newline sign
+ *
+ * @return line length, there is no terminating zero
+ */
+size_t elog_render (const char *record, size_t size, char *line, size_t line_size)
+{
+    extern size_t elog_line_terminate(char *message, size_t log_len, size_t max_len);
+
+    elog_header_t header;
+    size_t        prefix_len;
+    size_t        message_len;
+
+    if (size < sizeof(elog_header_t) || line_size <= strlen(ELOG_NEWLINE_SIGN))
+    {
+        return 0;
+    }
+    memcpy(&header, record, sizeof(elog_header_t));
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+    if (header.type == ELOG_RECORD_CALIB)
+    {
+        elog_render_calibrate(record);
+        return 0;
+    }
+#endif
+
+    /* leave room for the newline sign */
+    prefix_len  = elog_render_prefix(&header, line, line_size - strlen(ELOG_NEWLINE_SIGN));
+    message_len = header.message_length;
+    if (message_len > line_size - prefix_len)
+    {
+        message_len = line_size - prefix_len;
+    }
+    memcpy(line + prefix_len, record + sizeof(elog_header_t), message_len);
+
+    return prefix_len + elog_line_terminate(line + prefix_len, message_len, line_size - prefix_len);
+}
@@ -27,104 +27,1033 @@
  */
 
 #include <elog.h>
+#include <elog_ring_buf.h>
 #include <string.h>
+#include <stdatomic.h>
 
-/* buffer size for asynchronous output mode */
-#ifdef ELOG_ASYNC_OUTPUT_BUF_SIZE
-    #define RING_BUF_SIZE ELOG_ASYNC_OUTPUT_BUF_SIZE
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+/* records are packed, their compact headers are read byte by byte */
+    #define RING_ALIGN      1
+/* shorter than any compact header */
+    #define RING_RECORD_MIN 2
 #else
-    #define RING_BUF_SIZE (ELOG_LINE_BUF_SIZE * 10)
-#endif /* ELOG_ASYNC_OUTPUT_BUF_SIZE */
+/* every record starts at a multiple of the header alignment, so it can be read in place */
+    #define RING_ALIGN      _Alignof(elog_header_t)
+    #define RING_RECORD_MIN sizeof(elog_header_t)
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
 
-/* asynchronous output mode's ring buffer */
-static char ring_buf[RING_BUF_SIZE] = {0};
+#if defined(ELOG_ASYNC_PERSIST_ENABLE) && defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    #error "ELOG_ASYNC_PERSIST_ENABLE seals whole headers, it can't be used with ELOG_ASYNC_COMPACT_HEADER_ENABLE"
+#endif
 
-// current size of data in the buffer
-static size_t data_size = 0;
-/* log ring buffer write index */
-static size_t write_index = 0;
-/* log ring buffer read index */
-static size_t read_index = 0;
+/* read index flag, the consumer holds the top record */
+#define RING_READ_HELD   1
 
-size_t elog_buf_used (void)
+/* producers of elog_buf_push_shared in the low bits, the number of joins above them */
+#define RING_WRITERS_MASK 0xFF
+#define RING_WRITER_JOIN  (1 + (RING_WRITERS_MASK + 1))
+
+/*
+ * The ring indices run over [0, 2 * size), so a full ring can be told apart from an empty one.
+ * Records never straddle the end of the ring. When a record doesn't fit behind the write position,
+ * the rest of the ring is skipped: with a ELOG_RECORD_SKIP header when there is room for one,
+ * otherwise implicitly, because a tail shorter than a header can't hold a record. A compact ring
+ * marks every skipped tail with a COMPACT_SKIP byte.
+ * The read index is shifted left by one, it is advanced by the single consumer and by the producer
+ * when it evicts the oldest record. Its low bit (RING_READ_HELD) is set while the consumer reads
+ * the top record in place, the producer never evicts a held record.
+ */
+
+static size_t ring_offset (const elog_ring_buf_t *ring, size_t index)
+{
+    return (index < ring->size) ? index : index - ring->size;
+}
+
+static size_t ring_advance (const elog_ring_buf_t *ring, size_t index, size_t size)
+{
+    index += size;
+    return (index < 2 * ring->size) ? index : index - 2 * ring->size;
+}
+
+static size_t ring_distance (const elog_ring_buf_t *ring, size_t write, size_t read)
 {
-    return data_size;
+    return (write >= read) ? write - read : write + 2 * ring->size - read;
 }
 
-size_t elog_buf_avail (void)
+/* size a record takes in the ring, including the alignment padding behind it */
+static size_t ring_record_span (const elog_ring_buf_t *ring, size_t index, size_t size)
 {
-    return RING_BUF_SIZE - data_size;
+    size_t offset = ring_offset(ring, index);
+
+    size = (size + RING_ALIGN - 1) / RING_ALIGN * RING_ALIGN;
+    return (size > ring->size - offset) ? ring->size - offset : size;
 }
 
-int elog_buf_push (const char *log, size_t size)
+/* hold the top record so the producer can't evict it, consumer only */
+static size_t ring_hold (elog_ring_buf_t *ring)
 {
-    size_t available = elog_buf_avail();
-    if (size > available){
-    	return -1;
+    size_t read = atomic_load_explicit(&ring->read_index.index, memory_order_relaxed);
+
+    while (!(read & RING_READ_HELD)
+           && !atomic_compare_exchange_weak_explicit(&ring->read_index.index, &read, read | RING_READ_HELD,
+                                                     memory_order_acquire, memory_order_relaxed))
+    {
     }
 
-	size_t copy_size = size;
-	if (write_index + copy_size > RING_BUF_SIZE)
-	{
-		// wrap around
-		size_t first_chunk = RING_BUF_SIZE - write_index;
-		memcpy(&ring_buf[write_index], log, first_chunk);
-		memcpy(&ring_buf[0], &log[first_chunk], copy_size - first_chunk);
-		write_index = copy_size - first_chunk;
-	}
-	else
-	{
-		memcpy(&ring_buf[write_index], log, copy_size);
-		write_index += copy_size;
-	}
-	data_size += copy_size;
-	return 0;
+    return read >> 1;
+}
 
+/* move the read index and drop the hold, consumer only */
+static void ring_unhold (elog_ring_buf_t *ring, size_t read)
+{
+    /* hand the space back to the producer */
+    atomic_store_explicit(&ring->read_index.index, read << 1, memory_order_release);
 }
 
-int elog_buf_pop (char *log, uint16_t size)
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+/*
+ * A compact header is a flags byte followed by varints, the message follows it:
+ *  keyframe: flags, site id, sequence number (4 bytes), timestamp (8 bytes), message length
+ *  delta:    flags, site id, [sequence number delta], timestamp delta, message length
+ * The deltas are zigzag encoded and refer to the record written in front of it on the same ring.
+ * The consumer follows them from record to record, every ELOG_ASYNC_KEYFRAME_PERIOD records and after
+ * an eviction the producer writes a keyframe. Nothing is delta encoded by elog_buf_push_shared.
+ */
+    #define COMPACT_LVL_MASK   0x07
+    #define COMPACT_TYPE_SHIFT 3
+    #define COMPACT_TYPE_MASK  0x07 /* the record types fit in 3 bits */
+    #define COMPACT_SEQ_NEXT   0x40 /* sequence number delta 1, not stored */
+    #define COMPACT_KEY        0x80 /* keyframe */
+    #define COMPACT_SKIP       0xFF /* the rest of the ring is skipped, it isn't a valid level */
+/* longest compact header, a keyframe is shorter than elog_header_t for messages below 256 MiB */
+    #define COMPACT_HEADER_MAX (1 + 3 + 4 + 8 + 5)
+
+static size_t varint_put (uint8_t *out, uint64_t value)
 {
-    if (size > data_size)
+    size_t len = 0;
+
+    while (value >= 0x80)
     {
-        // can't pop it
-        return -1;
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+
+    return len;
+}
+
+static size_t varint_len (uint64_t value)
+{
+    size_t len = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        len++;
+    }
+
+    return len;
+}
+
+static size_t varint_get (const uint8_t *in, uint64_t *value)
+{
+    size_t len   = 0;
+    int    shift = 0;
+
+    *value = 0;
+    do
+    {
+        *value |= (uint64_t)(in[len] & 0x7F) << shift;
+        shift += 7;
+    } while (in[len++] & 0x80);
+
+    return len;
+}
+
+static uint64_t zigzag_encode (int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzag_decode (uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint64_t time_of (elog_timestamp_t timestamp)
+{
+    return (uint64_t)timestamp.high << 32 | timestamp.low;
+}
+
+static elog_timestamp_t timestamp_of (uint64_t time)
+{
+    elog_timestamp_t timestamp = {(uint32_t)time, (uint32_t)(time >> 32)};
+
+    return timestamp;
+}
+
+/**
+ * encode a record header
+ *
+ * @param header record header
+ * @param base record in front of it, NULL for a keyframe
+ * @param out compact header, COMPACT_HEADER_MAX bytes
+ *
+ * @return compact header size
+ */
+static size_t compact_encode (const elog_header_t *header, const elog_ring_base_t *base, uint8_t *out)
+{
+    uint64_t time  = time_of(header->timestamp);
+    uint8_t  flags = (header->level & COMPACT_LVL_MASK) | (header->type & COMPACT_TYPE_MASK) << COMPACT_TYPE_SHIFT;
+    size_t   len   = 1;
+
+    /* a wide jump (e.g. of a cycle counter timestamp) is shorter as a keyframe, so no header is longer */
+    if (base != NULL)
+    {
+        uint32_t seq_delta = header->seq_num - base->seq_num;
+        size_t   delta_len = varint_len(zigzag_encode((int64_t)(time - base->time)));
+
+        if (seq_delta != 1)
+        {
+            delta_len += varint_len(zigzag_encode((int32_t)seq_delta));
+        }
+        if (delta_len > sizeof(header->seq_num) + sizeof(time))
+        {
+            base = NULL;
+        }
+    }
+
+    len += varint_put(out + len, header->site_id);
+    if (base == NULL)
+    {
+        flags |= COMPACT_KEY;
+        memcpy(out + len, &header->seq_num, sizeof(header->seq_num));
+        len += sizeof(header->seq_num);
+        memcpy(out + len, &time, sizeof(time));
+        len += sizeof(time);
+    }
+    else
+    {
+        if (header->seq_num - base->seq_num == 1)
+        {
+            flags |= COMPACT_SEQ_NEXT;
+        }
+        else
+        {
+            len += varint_put(out + len, zigzag_encode((int32_t)(header->seq_num - base->seq_num)));
+        }
+        len += varint_put(out + len, zigzag_encode((int64_t)(time - base->time)));
+    }
+    len += varint_put(out + len, header->message_length);
+    out[0] = flags;
+
+    return len;
+}
+
+/**
+ * decode a compact header, the sequence number and timestamp of a delta stay deltas
+ *
+ * @param record compact record
+ * @param header record header
+ *
+ * @return compact header size
+ */
+static size_t compact_parse (const char *record, elog_header_t *header)
+{
+    const uint8_t *in    = (const uint8_t *)record;
+    uint8_t        flags = in[0];
+    size_t         len   = 1;
+    uint64_t       value;
+
+    header->level = flags & COMPACT_LVL_MASK;
+    header->type  = (flags >> COMPACT_TYPE_SHIFT) & COMPACT_TYPE_MASK;
+    len += varint_get(in + len, &value);
+    header->site_id = (uint16_t)value;
+    if (flags & COMPACT_KEY)
+    {
+        memcpy(&header->seq_num, in + len, sizeof(header->seq_num));
+        len += sizeof(header->seq_num);
+        memcpy(&value, in + len, sizeof(value));
+        len += sizeof(value);
+    }
+    else
+    {
+        header->seq_num = 1;
+        if (!(flags & COMPACT_SEQ_NEXT))
+        {
+            len += varint_get(in + len, &value);
+            header->seq_num = (uint32_t)zigzag_decode(value);
+        }
+        len += varint_get(in + len, &value);
+        value = (uint64_t)zigzag_decode(value);
+    }
+    header->timestamp = timestamp_of(value);
+    len += varint_get(in + len, &value);
+    header->message_length = (uint32_t)value;
+
+    return len;
+}
+
+/**
+ * add the base to the deltas of a parsed header and move the base to it
+ *
+ * @param record compact record
+ * @param header parsed header
+ * @param base record in front of it
+ */
+static void compact_rebase (const char *record, elog_header_t *header, elog_ring_base_t *base)
+{
+    if (!((uint8_t)record[0] & COMPACT_KEY))
+    {
+        header->seq_num += base->seq_num;
+        header->timestamp = timestamp_of(time_of(header->timestamp) + base->time);
     }
+    base->seq_num = header->seq_num;
+    base->time    = time_of(header->timestamp);
+}
+
+/**
+ * encode the header of the next record, producer only
+ *
+ * @param header record header
+ * @param out compact header, COMPACT_HEADER_MAX bytes
+ *
+ * @return compact header size
+ */
+static size_t ring_encode (const elog_ring_buf_t *ring, const elog_header_t *header, uint8_t *out)
+{
+    return compact_encode(header, (ring->encode_count != 0) ? &ring->encode_base : NULL, out);
+}
+
+/* move the producer's base to the record it published */
+static void ring_encoded (elog_ring_buf_t *ring, const elog_header_t *header)
+{
+    ring->encode_count         = (ring->encode_count != 0) ? ring->encode_count - 1 : ELOG_ASYNC_KEYFRAME_PERIOD - 1;
+    ring->encode_base.seq_num = header->seq_num;
+    ring->encode_base.time    = time_of(header->timestamp);
+}
+
+/* move the consumer's base past the top record at the read index */
+static void ring_read_base (elog_ring_buf_t *ring, size_t read)
+{
+    const char   *top = &ring->buf[ring_offset(ring, read)];
+    elog_header_t header;
+
+    compact_parse(top, &header);
+    compact_rebase(top, &header, &ring->read_base);
+}
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
 
-    if (read_index + size > RING_BUF_SIZE)
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+/* longest run a Fletcher-16 sum can take in 32 bits before it must be reduced */
+#define FLETCHER_RUN_MAX 5802
+
+static void fletcher_add (uint32_t *sum1, uint32_t *sum2, const uint8_t *data, size_t size)
+{
+    while (size > 0)
     {
-        // wrap around
-        size_t first_chunk = RING_BUF_SIZE - read_index;
-        memcpy(log, &ring_buf[read_index], first_chunk);
-        memcpy(&log[first_chunk], &ring_buf[0], size - first_chunk);
-        read_index = size-first_chunk;
+        size_t run = (size < FLETCHER_RUN_MAX) ? size : FLETCHER_RUN_MAX;
+
+        size -= run;
+        while (run-- > 0)
+        {
+            *sum1 += *data++;
+            *sum2 += *sum1;
+        }
+        *sum1 %= 255;
+        *sum2 %= 255;
+    }
+}
+
+/* bytes behind the header the checksum covers, the padding behind a skip header isn't covered */
+static size_t record_payload_len (const elog_header_t *header)
+{
+    return (header->type == ELOG_RECORD_SKIP) ? 0 : header->message_length;
+}
+
+/* Fletcher-16 of the header, with the checksum taken as 0, and the payload */
+static uint16_t record_checksum (const elog_header_t *header, const char *payload)
+{
+    elog_header_t sealed = *header;
+    uint32_t      sum1   = 0;
+    uint32_t      sum2   = 0;
+
+    sealed.checksum = 0;
+    fletcher_add(&sum1, &sum2, (const uint8_t *)&sealed, sizeof(sealed));
+    fletcher_add(&sum1, &sum2, (const uint8_t *)payload, record_payload_len(header));
+
+    return (uint16_t)((sum2 << 8) | sum1);
+}
+
+/* set the magic and checksum of the record at offset, before it is published */
+static void ring_seal (elog_ring_buf_t *ring, size_t offset)
+{
+    elog_header_t header;
+
+    memcpy(&header, &ring->buf[offset], sizeof(elog_header_t));
+    header.magic    = ELOG_RECORD_MAGIC;
+    header.checksum = record_checksum(&header, &ring->buf[offset + sizeof(elog_header_t)]);
+    memcpy(&ring->buf[offset], &header, sizeof(elog_header_t));
+}
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
+/* skip the tail behind offset, the consumer jumps back to the ring start */
+static void ring_skip_tail (elog_ring_buf_t *ring, size_t offset)
+{
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    /* the offset is inside the ring, so the tail has room for the marker */
+    ring->buf[offset] = (char)COMPACT_SKIP;
+#else
+    size_t tail = ring->size - offset;
+
+    if (tail >= sizeof(elog_header_t))
+    {
+        elog_header_t skip_header = {0};
+        skip_header.type           = ELOG_RECORD_SKIP;
+        skip_header.message_length = tail - sizeof(elog_header_t);
+        memcpy(&ring->buf[offset], &skip_header, sizeof(elog_header_t));
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+        ring_seal(ring, offset);
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+    }
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+}
+
+/**
+ * initialize a ring buffer on the given storage, it is empty
+ *
+ * @param ring ring buffer
+ * @param buf storage, aligned to elog_header_t
+ * @param size storage size
+ */
+void elog_buf_init (elog_ring_buf_t *ring, char *buf, size_t size)
+{
+    memset(ring, 0, sizeof(elog_ring_buf_t));
+    ring->buf  = buf;
+    ring->size = size;
+}
+
+size_t elog_buf_used (elog_ring_buf_t *ring)
+{
+    size_t write = atomic_load_explicit(&ring->write_index.index, memory_order_acquire);
+    size_t read  = atomic_load_explicit(&ring->read_index.index, memory_order_acquire) >> 1;
+
+    return ring_distance(ring, write, read);
+}
+
+size_t elog_buf_avail (elog_ring_buf_t *ring)
+{
+    return ring->size - elog_buf_used(ring);
+}
+
+/**
+ * reserve a contiguous slot for the producer to write a record in place
+ * The slot stays behind the write position when the whole size fits there, otherwise the bigger
+ * of the remaining tail and the free space at the ring start is used.
+ *
+ * @param ring ring buffer
+ * @param size wanted slot size
+ * @param capacity reserved slot size, it may be less than the wanted size
+ *
+ * @return slot, NULL when the ring buffer has no room for a record header
+ */
+char *elog_buf_reserve (elog_ring_buf_t *ring, size_t size, size_t *capacity)
+{
+    /* acquire the read index so the consumer has finished reading the space we are about to overwrite */
+    size_t read   = atomic_load_explicit(&ring->read_index.index, memory_order_acquire) >> 1;
+    size_t write  = atomic_load_explicit(&ring->write_index.index, memory_order_relaxed);
+    size_t free   = ring->size - ring_distance(ring, write, read);
+    size_t offset = ring_offset(ring, write);
+    size_t tail   = ring->size - offset;
+
+    size_t tail_run = (free < tail) ? free : tail;
+    size_t head_run = (free > tail) ? free - tail : 0;
+
+    if (tail_run >= size || tail_run >= head_run)
+    {
+        ring->reserve_index    = write;
+        ring->reserve_capacity = tail_run;
     }
     else
     {
-        memcpy(log, &ring_buf[read_index], size);
-        read_index += size;
+        ring_skip_tail(ring, offset);
+        ring->reserve_index    = ring_advance(ring, write, tail);
+        ring->reserve_capacity = head_run;
+        offset           = 0;
+    }
+
+    if (ring->reserve_capacity < RING_RECORD_MIN)
+    {
+        return NULL;
     }
-    data_size -= size;
+    if (ring->reserve_capacity > size)
+    {
+        ring->reserve_capacity = size;
+    }
+
+    *capacity = ring->reserve_capacity;
+    return &ring->buf[offset];
+}
+
+/* publish the record in the reserved slot (and the skipped tail in front of it) to the consumer */
+static void ring_publish (elog_ring_buf_t *ring, size_t size)
+{
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+    ring_seal(ring, ring_offset(ring, ring->reserve_index));
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+    /* keep the next one aligned */
+    atomic_store_explicit(&ring->write_index.index, ring_advance(ring, ring->reserve_index, ring_record_span(ring, ring->reserve_index, size)),
+                          memory_order_release);
+    ring->reserve_capacity = 0;
+}
+
+/**
+ * publish the record written to the reserved slot, a reserved slot that isn't committed is dropped
+ * A compact ring encodes the elog_header_t in front of the payload in place.
+ *
+ * @param ring ring buffer
+ * @param size record size, not more than the reserved capacity
+ *
+ * @return 0: success, -1: the size exceeds the reservation
+ */
+int elog_buf_commit (elog_ring_buf_t *ring, size_t size)
+{
+    if (size > ring->reserve_capacity)
+    {
+        return -1;
+    }
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    char         *slot = &ring->buf[ring_offset(ring, ring->reserve_index)];
+    elog_header_t header;
+    uint8_t       compact[COMPACT_HEADER_MAX];
+    size_t        compact_size;
+
+    memcpy(&header, slot, sizeof(elog_header_t));
+    compact_size = ring_encode(ring, &header, compact);
+    memmove(slot + compact_size, slot + sizeof(elog_header_t), size - sizeof(elog_header_t));
+    memcpy(slot, compact, compact_size);
+    size = size - sizeof(elog_header_t) + compact_size;
+    ring_encoded(ring, &header);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+
+    ring_publish(ring, size);
     return 0;
 }
 
-int elog_buf_peek (elog_header_t *header)
+int elog_buf_push (elog_ring_buf_t *ring, const char *log, size_t size)
 {
-    if (data_size < sizeof(elog_header_t))
+    size_t capacity;
+    size_t header_size = 0;
+    char  *slot;
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    elog_header_t header;
+    uint8_t       compact[COMPACT_HEADER_MAX];
+
+    memcpy(&header, log, sizeof(elog_header_t));
+    header_size = ring_encode(ring, &header, compact);
+    log += sizeof(elog_header_t);
+    size += header_size - sizeof(elog_header_t);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+
+    slot = elog_buf_reserve(ring, size, &capacity);
+    if (slot == NULL || capacity < size)
     {
-        // can't peek it
         return -1;
     }
-    if (read_index + sizeof(elog_header_t) > RING_BUF_SIZE)
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    memcpy(slot, compact, header_size);
+    ring_encoded(ring, &header);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+    memcpy(slot + header_size, log, size - header_size);
+    ring_publish(ring, size);
+    return 0;
+}
+
+/**
+ * push a record from producers that aren't serialized, e.g. nested interrupts, without any lock
+ * The space is claimed with a CAS on the claim index. The claimed records are published together
+ * by a producer that finds itself alone before it leaves, so the consumer never sees a claimed record
+ * before it is written. Up to 255 producers may be in at once (interrupt nesting depth).
+ * It can't be mixed with elog_buf_push/elog_buf_reserve/elog_buf_evict on the same ring buffer.
+ * A compact ring gets keyframes only, the producers share no base.
+ *
+ * @param ring ring buffer
+ * @param log record, header and payload
+ * @param size record size
+ *
+ * @return 0: success, -1: the ring buffer is full
+ */
+int elog_buf_push_shared (elog_ring_buf_t *ring, const char *log, size_t size)
+{
+    size_t   claim, start = 0, end;
+    size_t   header_size = 0;
+    int      result;
+    unsigned writers;
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    elog_header_t header;
+    uint8_t       compact[COMPACT_HEADER_MAX];
+
+    memcpy(&header, log, sizeof(elog_header_t));
+    header_size = compact_encode(&header, NULL, compact);
+    log += sizeof(elog_header_t);
+    size += header_size - sizeof(elog_header_t);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+    result = (size <= ring->size) ? 0 : -1;
+
+    /* join before claiming, so a leaving producer can tell if claims are still being written */
+    atomic_fetch_add_explicit(&ring->writers, RING_WRITER_JOIN, memory_order_acq_rel);
+
+    claim = atomic_load_explicit(&ring->claim_index.index, memory_order_relaxed);
+    while (result == 0)
+    {
+        size_t read = atomic_load_explicit(&ring->read_index.index, memory_order_acquire) >> 1;
+        size_t tail = ring->size - ring_offset(ring, claim);
+        size_t skip = (size > tail) ? tail : 0;
+        size_t span;
+
+        /* the record starts at the ring start when the tail is too short for it */
+        start = ring_advance(ring, claim, skip);
+        span  = ring_record_span(ring, start, size);
+        end   = ring_advance(ring, start, span);
+        if (ring_distance(ring, claim, read) + skip + span > ring->size)
+        {
+            result = -1;
+        }
+        else if (atomic_compare_exchange_weak_explicit(&ring->claim_index.index, &claim, end, memory_order_acq_rel,
+                                                       memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    if (result == 0)
     {
-        // wrap around
-        memcpy(header, &ring_buf[read_index], RING_BUF_SIZE - read_index);
-        memcpy((char *)header + RING_BUF_SIZE - read_index,
-               &ring_buf[0],
-               sizeof(elog_header_t) - (RING_BUF_SIZE - read_index));
+        if (start != claim)
+        {
+            ring_skip_tail(ring, ring_offset(ring, claim));
+        }
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+        memcpy(&ring->buf[ring_offset(ring, start)], compact, header_size);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+        memcpy(&ring->buf[ring_offset(ring, start)] + header_size, log, size - header_size);
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+        ring_seal(ring, ring_offset(ring, start));
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
     }
+
+    /*
+     * Leave, publishing everything claimed so far when no other producer is in. A producer that joins
+     * meanwhile changes the join count, so the leave is retried and sees its claim too. The producer
+     * alone is the only one that can publish, so the write index never goes back.
+     */
+    writers = atomic_load_explicit(&ring->writers, memory_order_acquire);
+    do
+    {
+        if ((writers & RING_WRITERS_MASK) == 1)
+        {
+            claim = atomic_load_explicit(&ring->claim_index.index, memory_order_acquire);
+            /* nobody joined before the claim index was read, so all of it is written */
+            if (atomic_load_explicit(&ring->writers, memory_order_acquire) == writers)
+            {
+                atomic_store_explicit(&ring->write_index.index, claim, memory_order_release);
+            }
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring->writers, &writers, writers - 1, memory_order_acq_rel,
+                                                    memory_order_acquire));
+
+    return result;
+}
+
+/**
+ * find the next record at or behind the given read index, skipping the padding at the ring end
+ *
+ * @param read read index, it is moved past any padding
+ * @param write write index
+ * @param record next record
+ * @param size next record size
+ *
+ * @return true when there is a record
+ */
+static bool ring_next_record (const elog_ring_buf_t *ring, size_t *read, size_t write, const char **record, size_t *size)
+{
+    while (ring_distance(ring, write, *read) != 0)
+    {
+        size_t        offset = ring_offset(ring, *read);
+        elog_header_t header;
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+        if ((uint8_t)ring->buf[offset] == COMPACT_SKIP)
+        {
+            *read = ring_advance(ring, *read, ring->size - offset);
+            continue;
+        }
+
+        *record = &ring->buf[offset];
+        *size   = compact_parse(*record, &header) + header.message_length;
+#else
+        if (ring->size - offset < sizeof(elog_header_t))
+        {
+            /* implicitly skipped tail */
+            *read = ring_advance(ring, *read, ring->size - offset);
+            continue;
+        }
+
+        memcpy(&header, &ring->buf[offset], sizeof(elog_header_t));
+        if (header.type == ELOG_RECORD_SKIP)
+        {
+            *read = ring_advance(ring, *read, ring->size - offset);
+            continue;
+        }
+
+        *record = &ring->buf[offset];
+        *size   = sizeof(elog_header_t) + header.message_length;
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * get the top record in place, it is held until it is released by elog_buf_release
+ *
+ * @param ring ring buffer
+ * @param record top record, header and payload
+ * @param size top record size
+ *
+ * @return 0: success, -1: the ring buffer is empty
+ */
+int elog_buf_peek_span (elog_ring_buf_t *ring, const char **record, size_t *size)
+{
+    size_t read  = ring_hold(ring);
+    size_t write = atomic_load_explicit(&ring->write_index.index, memory_order_acquire);
+    size_t top   = read;
+
+    if (!ring_next_record(ring, &top, write, record, size))
+    {
+        ring_unhold(ring, top);
+        return -1;
+    }
+    if (top != read)
+    {
+        /* hand the skipped padding back to the producer, the record stays held */
+        atomic_store_explicit(&ring->read_index.index, top << 1 | RING_READ_HELD, memory_order_release);
+    }
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    ring->decode_top = *record;
+#endif
+
+    return 0;
+}
+
+/**
+ * get up to max_count records in place, starting with the top record
+ * The records stay valid until they are released by elog_buf_release_batch.
+ *
+ * @param ring ring buffer
+ * @param records records, header and payload each
+ * @param max_count maximum number of records
+ *
+ * @return number of records
+ */
+size_t elog_buf_peek_batch (elog_ring_buf_t *ring, elog_span_t *records, size_t max_count)
+{
+    size_t read  = ring_hold(ring);
+    size_t write = atomic_load_explicit(&ring->write_index.index, memory_order_acquire);
+    size_t count = 0;
+
+    while (count < max_count && ring_next_record(ring, &read, write, &records[count].data, &records[count].size))
+    {
+        read = ring_advance(ring, read, ring_record_span(ring, read, records[count].size));
+        count++;
+    }
+    if (count == 0)
+    {
+        ring_unhold(ring, read);
+    }
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
     else
     {
-        memcpy(header, &ring_buf[read_index], sizeof(elog_header_t));
+        ring->decode_top = records[0].data;
     }
+#endif
+
+    return count;
+}
+
+/**
+ * release the top record after it was consumed in place
+ *
+ * @param ring ring buffer
+ * @param size top record size from elog_buf_peek_span, 0 gives the record back without consuming it
+ */
+void elog_buf_release (elog_ring_buf_t *ring, size_t size)
+{
+    size_t read = atomic_load_explicit(&ring->read_index.index, memory_order_relaxed) >> 1;
+
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    if (size != 0)
+    {
+        ring_read_base(ring, read);
+    }
+#endif
+    ring_unhold(ring, ring_advance(ring, read, (size != 0) ? ring_record_span(ring, read, size) : 0));
+}
+
+/**
+ * release the records got by elog_buf_peek_batch
+ *
+ * @param ring ring buffer
+ * @param count number of records
+ */
+void elog_buf_release_batch (elog_ring_buf_t *ring, size_t count)
+{
+    size_t      write = atomic_load_explicit(&ring->write_index.index, memory_order_acquire);
+    size_t      read  = atomic_load_explicit(&ring->read_index.index, memory_order_relaxed) >> 1;
+    const char *record;
+    size_t      size;
+
+    while (count-- > 0 && ring_next_record(ring, &read, write, &record, &size))
+    {
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+        ring_read_base(ring, read);
+#endif
+        read = ring_advance(ring, read, ring_record_span(ring, read, size));
+    }
+
+    ring_unhold(ring, read);
+}
+
+/**
+ * check if an eviction may stop in front of the record at the given index
+ * The consumer can't decode a compact delta to an evicted record, so a compact ring is evicted up to
+ * the next keyframe or empty.
+ */
+static bool ring_evict_stop (const elog_ring_buf_t *ring, size_t index, size_t write)
+{
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    const char *record;
+    size_t      size;
+
+    return !ring_next_record(ring, &index, write, &record, &size) || ((uint8_t)record[0] & COMPACT_KEY);
+#else
+    (void)ring;
+    (void)index;
+    (void)write;
+    return true;
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+}
+
+/**
+ * evict the oldest record to make room for a new one, producer only
+ * The record the consumer currently reads in place is never evicted. A compact ring evicts up to the
+ * next keyframe and writes a keyframe next, ELOG_RING_EVICT_MAX records at most.
+ *
+ * @param ring ring buffer
+ * @param records evicted records, they stay readable until the producer writes the next one
+ * @param max_count maximum number of records, ELOG_RING_EVICT_MAX
+ *
+ * @return number of records, 0: the ring buffer is empty or its oldest record is held by the consumer
+ */
+size_t elog_buf_evict (elog_ring_buf_t *ring, elog_span_t *records, size_t max_count)
+{
+    size_t write = atomic_load_explicit(&ring->write_index.index, memory_order_relaxed);
+    size_t read  = atomic_load_explicit(&ring->read_index.index, memory_order_acquire);
+
+    do
+    {
+        size_t oldest = read >> 1;
+        size_t count  = 0;
+        bool   stop   = false;
+
+        if (read & RING_READ_HELD)
+        {
+            return 0;
+        }
+        while (!stop && count < max_count
+               && ring_next_record(ring, &oldest, write, &records[count].data, &records[count].size))
+        {
+            oldest = ring_advance(ring, oldest, ring_record_span(ring, oldest, records[count].size));
+            stop   = ring_evict_stop(ring, oldest, write);
+            count++;
+        }
+        if (!stop)
+        {
+            return 0;
+        }
+
+        /* fails when the consumer has taken or held the record meanwhile, look at the new oldest one then */
+        if (atomic_compare_exchange_weak_explicit(&ring->read_index.index, &read, oldest << 1, memory_order_acq_rel,
+                                                  memory_order_acquire))
+        {
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+            ring->encode_count = 0;
+#endif
+            return count;
+        }
+    } while (true);
+}
+
+/**
+ * decode the header of a record got by elog_buf_peek_span or elog_buf_peek_batch, consumer only
+ * The top record may be decoded any time, the records behind it only in the order they were got.
+ *
+ * @param ring ring buffer
+ * @param record record
+ * @param header record header
+ *
+ * @return size of the header in front of the message
+ */
+size_t elog_buf_decode (elog_ring_buf_t *ring, const char *record, elog_header_t *header)
+{
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    size_t header_size = compact_parse(record, header);
+
+    if (record == ring->decode_top)
+    {
+        ring->decode_base = ring->read_base;
+    }
+    compact_rebase(record, header, &ring->decode_base);
+    return header_size;
+#else
+    (void)ring;
+    return elog_buf_parse(record, header);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+}
+
+/**
+ * decode a record header without the consumer's base, e.g. of an evicted record
+ *
+ * @param record record
+ * @param header record header, the sequence number and timestamp of a compact delta stay deltas
+ *
+ * @return size of the header in front of the message
+ */
+size_t elog_buf_parse (const char *record, elog_header_t *header)
+{
+#if defined(ELOG_ASYNC_COMPACT_HEADER_ENABLE)
+    return compact_parse(record, header);
+#else
+    memcpy(header, record, sizeof(elog_header_t));
+    return sizeof(elog_header_t);
+#endif /* ELOG_ASYNC_COMPACT_HEADER_ENABLE */
+}
+
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+/**
+ * Take over a ring buffer the previous boot left in persistent storage. The records from its read index
+ * to its write index are walked and validated, the ring ends in front of the first one with a wrong
+ * magic, length or checksum. A ring of another size is initialized empty instead.
+ * Nothing else may use the ring buffer meanwhile.
+ *
+ * @param ring ring buffer, as the previous boot left it
+ * @param buf storage, it may be mapped at another address than before
+ * @param size storage size
+ * @param newest_seq sequence number of the newest recovered record, only set when there is one
+ *
+ * @return number of recovered records
+ */
+size_t elog_buf_recover (elog_ring_buf_t *ring, char *buf, size_t size, uint32_t *newest_seq)
+{
+    /* the consumer may have held the top record, it wasn't released */
+    size_t read  = atomic_load_explicit(&ring->read_index.index, memory_order_relaxed) >> 1;
+    size_t write = atomic_load_explicit(&ring->write_index.index, memory_order_relaxed);
+    size_t count = 0;
+
+    if (ring->size != size || read >= 2 * size || write >= 2 * size || read % RING_ALIGN != 0
+        || write % RING_ALIGN != 0)
+    {
+        elog_buf_init(ring, buf, size);
+        return 0;
+    }
+    ring->buf = buf;
+
+    size_t index = read;
+    while (ring_distance(ring, write, index) != 0)
+    {
+        size_t        offset = ring_offset(ring, index);
+        size_t        tail   = ring->size - offset;
+        elog_header_t header;
+
+        if (tail < sizeof(elog_header_t))
+        {
+            /* implicitly skipped tail */
+            index = ring_advance(ring, index, tail);
+            continue;
+        }
+        memcpy(&header, &buf[offset], sizeof(elog_header_t));
+        if (header.magic != ELOG_RECORD_MAGIC || record_payload_len(&header) > tail - sizeof(elog_header_t)
+            || header.checksum != record_checksum(&header, &buf[offset + sizeof(elog_header_t)]))
+        {
+            break;
+        }
+        if (header.type == ELOG_RECORD_SKIP)
+        {
+            index = ring_advance(ring, index, tail);
+            continue;
+        }
+
+        if (count == 0 || (int32_t)(header.seq_num - *newest_seq) > 0)
+        {
+            *newest_seq = header.seq_num;
+        }
+        count++;
+        index = ring_advance(ring, index, ring_record_span(ring, index, sizeof(elog_header_t) + header.message_length));
+    }
+
+    /* drop what the producers and the consumer were in the middle of */
+    atomic_store_explicit(&ring->read_index.index, read << 1, memory_order_relaxed);
+    atomic_store_explicit(&ring->write_index.index, index, memory_order_relaxed);
+    atomic_store_explicit(&ring->claim_index.index, index, memory_order_relaxed);
+    atomic_store_explicit(&ring->writers, 0, memory_order_relaxed);
+    ring->reserve_index    = index;
+    ring->reserve_capacity = 0;
+
+    return count;
+}
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
+int elog_buf_pop (elog_ring_buf_t *ring, char *log, size_t size)
+{
+    const char   *record;
+    size_t        record_size, header_size;
+    elog_header_t header;
+
+    if (elog_buf_peek_span(ring, &record, &record_size) != 0)
+    {
+        // can't pop it
+        return -1;
+    }
+    header_size = elog_buf_decode(ring, record, &header);
+    if (size < sizeof(elog_header_t) + header.message_length)
+    {
+        elog_buf_release(ring, 0);
+        return -1;
+    }
+
+    /* the header is handed out whole, also when the ring keeps it compact */
+    memcpy(log, &header, sizeof(elog_header_t));
+    memcpy(log + sizeof(elog_header_t), record + header_size, header.message_length);
+    elog_buf_release(ring, record_size);
+    return 0;
+}
+
+int elog_buf_peek (elog_ring_buf_t *ring, elog_header_t *header)
+{
+    const char *record;
+    size_t      record_size;
+
+    if (elog_buf_peek_span(ring, &record, &record_size) != 0)
+    {
+        // can't peek it
+        return -1;
+    }
+
+    elog_buf_decode(ring, record, header);
+    elog_buf_release(ring, 0);
     return 0;
 }
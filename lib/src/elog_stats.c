@@ -0,0 +1,190 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Logger self-instrumentation, counters, ring buffer high-watermarks and latency histograms.
+ * Created on: 2026-10-17
+ */
+
+#define LOG_TAG "elog.stats"
+
+#include <elog.h>
+#include <elog_stats.h>
+
+#if defined(ELOG_STATS_ENABLE)
+
+/* period of the statistics log emitted by the drain, in elog_port_get_time units, 0: never */
+#ifndef ELOG_STATS_OUTPUT_PERIOD
+    #define ELOG_STATS_OUTPUT_PERIOD 0
+#endif /* ELOG_STATS_OUTPUT_PERIOD */
+
+elog_stats_counter_t elog_stats_counter;
+
+extern elog_timestamp_t elog_port_get_time (void);
+
+/**
+ * statistics time port interface, the default uses the low word of elog_port_get_time
+ * A port should return a finer clock, e.g. the cycle counter, the latency histograms are in its units.
+ *
+ * @return current time, it may wrap around
+ */
+__attribute__((weak)) uint32_t elog_port_stats_time (void)
+{
+    return elog_port_get_time().low;
+}
+
+/**
+ * raise the high-watermark of a lane
+ *
+ * @param lane ELOG_STATS_LANE_ISR, ELOG_STATS_LANE_HIGH or ELOG_STATS_LANE_OUTPUT
+ * @param used bytes the lane holds
+ */
+void elog_stats_peak (uint8_t lane, size_t used)
+{
+    uint32_t peak = atomic_load_explicit(&elog_stats_counter.ring_peak[lane], memory_order_relaxed);
+
+    while (used > peak
+           && !atomic_compare_exchange_weak_explicit(&elog_stats_counter.ring_peak[lane], &peak, (uint32_t)used,
+                                                     memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * get the time for the latency histograms
+ *
+ * @return current time in elog_port_stats_time units
+ */
+uint32_t elog_stats_time (void)
+{
+    return elog_port_stats_time();
+}
+
+/**
+ * count the time since start in a latency histogram
+ *
+ * @param hist latency histogram, ELOG_STATS_HIST_NUM buckets
+ * @param start time got by elog_stats_time
+ */
+void elog_stats_hist (_Atomic uint32_t *hist, uint32_t start)
+{
+    uint32_t time   = elog_port_stats_time() - start;
+    size_t   bucket = (time == 0) ? 0 : 32 - (size_t)__builtin_clz(time);
+
+    if (bucket >= ELOG_STATS_HIST_NUM)
+    {
+        bucket = ELOG_STATS_HIST_NUM - 1;
+    }
+    atomic_fetch_add_explicit(&hist[bucket], 1, memory_order_relaxed);
+}
+
+/**
+ * get a copy of the counters, every counter is read on its own while the others may go on
+ *
+ * @param stats counters
+ */
+void elog_get_stats (elog_stats_t *stats)
+{
+    stats->records     = atomic_load_explicit(&elog_stats_counter.records, memory_order_relaxed);
+    stats->bytes       = atomic_load_explicit(&elog_stats_counter.bytes, memory_order_relaxed);
+    stats->ring_drops  = atomic_load_explicit(&elog_stats_counter.ring_drops, memory_order_relaxed);
+    stats->lock_fails  = atomic_load_explicit(&elog_stats_counter.lock_fails, memory_order_relaxed);
+    stats->truncations = atomic_load_explicit(&elog_stats_counter.truncations, memory_order_relaxed);
+    for (size_t i = 0; i < ELOG_STATS_LANE_NUM; i++)
+    {
+        stats->ring_peak[i] = atomic_load_explicit(&elog_stats_counter.ring_peak[i], memory_order_relaxed);
+    }
+    for (size_t i = 0; i < ELOG_STATS_HIST_NUM; i++)
+    {
+        stats->output_time[i] = atomic_load_explicit(&elog_stats_counter.output_time[i], memory_order_relaxed);
+        stats->drain_time[i]  = atomic_load_explicit(&elog_stats_counter.drain_time[i], memory_order_relaxed);
+    }
+}
+
+/**
+ * get the upper bound of the histogram bucket a percentile falls in
+ *
+ * @param hist latency histogram
+ * @param percent percentile, 1 to 100
+ *
+ * @return the percentile is below it, 0 when the histogram is empty
+ */
+static unsigned long hist_percentile (const uint32_t *hist, uint32_t percent)
+{
+    uint64_t total = 0, count = 0;
+
+    for (size_t i = 0; i < ELOG_STATS_HIST_NUM; i++)
+    {
+        total += hist[i];
+    }
+    for (size_t i = 0; i < ELOG_STATS_HIST_NUM; i++)
+    {
+        count += hist[i];
+        if (count != 0 && count * 100 >= total * percent)
+        {
+            return 1UL << i;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * output the counters as an info log of the "elog.stats" tag
+ * The latencies are the bucket bounds of the median and the 99th percentile, in elog_port_stats_time units.
+ */
+void elog_stats_output (void)
+{
+    elog_stats_t stats;
+
+    elog_get_stats(&stats);
+    elog_i(LOG_TAG, "records %lu, bytes %lu, ring drops %lu, lock fails %lu, truncations %lu, peak %lu/%lu/%lu",
+           (unsigned long)stats.records, (unsigned long)stats.bytes, (unsigned long)stats.ring_drops,
+           (unsigned long)stats.lock_fails, (unsigned long)stats.truncations,
+           (unsigned long)stats.ring_peak[ELOG_STATS_LANE_ISR], (unsigned long)stats.ring_peak[ELOG_STATS_LANE_HIGH],
+           (unsigned long)stats.ring_peak[ELOG_STATS_LANE_OUTPUT]);
+    elog_i(LOG_TAG, "output p50 <%lu p99 <%lu, drain p50 <%lu p99 <%lu", hist_percentile(stats.output_time, 50),
+           hist_percentile(stats.output_time, 99), hist_percentile(stats.drain_time, 50),
+           hist_percentile(stats.drain_time, 99));
+}
+
+/**
+ * output the counters every ELOG_STATS_OUTPUT_PERIOD, called by the single drain task
+ */
+void elog_stats_poll (void)
+{
+#if ELOG_STATS_OUTPUT_PERIOD > 0
+    static uint64_t last_time = 0;
+
+    elog_timestamp_t stamp = elog_port_get_time();
+    uint64_t         time  = (uint64_t)stamp.high << 32 | stamp.low;
+
+    if (time - last_time >= ELOG_STATS_OUTPUT_PERIOD)
+    {
+        last_time = time;
+        elog_stats_output();
+    }
+#endif /* ELOG_STATS_OUTPUT_PERIOD > 0 */
+}
+
+#endif /* ELOG_STATS_ENABLE */
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Cycle-counter timestamps, the calibration records turn them into wall time.
+ * Created on: 2026-10-17
+ */
+
+#include <elog.h>
+#include <string.h>
+
+/*
+ * With ELOG_TIME_COUNTER_ENABLE the records are stamped with elog_port_get_counter, which is much cheaper
+ * than a clock read. Every ELOG_TIME_CALIB_PERIOD counter ticks the producer puts a calibration record in
+ * front of a log:
+ *
+ *   header: type ELOG_RECORD_CALIB, timestamp the counter
+ *   message: elog_timestamp_t, elog_port_get_time at that counter
+ *
+ * A consumer feeds them to an elog_calib_t in log order. A counter is turned into wall time from the last
+ * calibration record, with the counter rate measured between the last two (ELOG_TIME_COUNTER_FREQ before
+ * there are two). A counter going back means a new boot, the conversion starts over.
+ */
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+
+static uint64_t ticks_of (elog_timestamp_t timestamp)
+{
+    return (uint64_t)timestamp.high << 32 | timestamp.low;
+}
+
+static elog_timestamp_t timestamp_of (uint64_t ticks)
+{
+    elog_timestamp_t timestamp = {(uint32_t)ticks, (uint32_t)(ticks >> 32)};
+
+    return timestamp;
+}
+
+/**
+ * take a calibration record
+ *
+ * @param calib counter conversion, zeroed before the first record
+ * @param record calibration record, header and message
+ */
+void elog_calib_update (elog_calib_t *calib, const char *record)
+{
+    elog_header_t    header;
+    elog_timestamp_t wall;
+    uint64_t         counter, time;
+
+    memcpy(&header, record, sizeof(elog_header_t));
+    if (header.type != ELOG_RECORD_CALIB || header.message_length < sizeof(wall))
+    {
+        return;
+    }
+    memcpy(&wall, record + sizeof(elog_header_t), sizeof(wall));
+    counter = ticks_of(header.timestamp);
+    time    = ticks_of(wall);
+
+    if (!calib->valid || counter < calib->counter)
+    {
+        calib->ratio = (double)ELOG_FMT_TIME_FREQ / ELOG_TIME_COUNTER_FREQ;
+    }
+    else if (counter == calib->counter)
+    {
+        /* the same record again */
+        return;
+    }
+    else if (time > calib->time)
+    {
+        calib->ratio = (double)(time - calib->time) / (double)(counter - calib->counter);
+    }
+    /* a wall clock set back keeps the rate, the time goes on from the new pair */
+    calib->counter = counter;
+    calib->time    = time;
+    calib->valid   = true;
+}
+
+/**
+ * turn a counter into wall time
+ *
+ * @param calib counter conversion
+ * @param counter record timestamp, elog_port_get_counter ticks
+ *
+ * @return wall time in elog_port_get_time ticks
+ */
+elog_timestamp_t elog_calib_time (const elog_calib_t *calib, elog_timestamp_t counter)
+{
+    uint64_t ticks = ticks_of(counter);
+    double   delta;
+
+    if (!calib->valid)
+    {
+        return timestamp_of((uint64_t)((double)ticks * ELOG_FMT_TIME_FREQ / ELOG_TIME_COUNTER_FREQ));
+    }
+
+    /* a record of the ISR lane may be a little older than the calibration record in front of it */
+    delta = (double)(int64_t)(ticks - calib->counter) * calib->ratio;
+    return timestamp_of(calib->time + (uint64_t)(int64_t)(delta + ((delta < 0) ? -0.5 : 0.5)));
+}
+
+#endif /* ELOG_TIME_COUNTER_ENABLE */
@@ -29,11 +29,92 @@
 #ifndef _ELOG_CFG_H_
 #define _ELOG_CFG_H_
 /*---------------------------------------------------------------------------*/
+/* static output level, logs above it are compiled out (a source file may override it with LOG_LVL) */
+#define ELOG_OUTPUT_LVL ELOG_LVL_VERBOSE
+/* output filter's tag max length */
+#define ELOG_FILTER_TAG_MAX_LEN 30
+/* output filter's tag level max num, the filter table is a hash table */
+#define ELOG_FILTER_TAG_LVL_MAX_NUM 8
+/* rate limit every call site with a token bucket, suppressed logs are summarized when the burst ends, by the
+ * drain or, without asynchronous output, by elog_rate_limit_flush called from the application */
+// #define ELOG_RATE_LIMIT_ENABLE
+/* logs a call site may output in a burst (1 to 127) */
+#define ELOG_RATE_LIMIT_BURST 10
+/* time to refill one token, in elog_port_get_time units (read from the counter in counter mode) */
+#define ELOG_RATE_LIMIT_INTERVAL 100
+/* prefix fields of every level until elog_set_fmt changes them */
+#define ELOG_FMT_DEFAULT (ELOG_FMT_TIME | ELOG_FMT_LVL | ELOG_FMT_TAG)
+/* elog_port_get_time ticks per second */
+#define ELOG_FMT_TIME_FREQ 1000
+/* stamp the logs with the cycle counter of elog_port_get_counter, a calibration record pairs it with
+ * elog_port_get_time every ELOG_TIME_CALIB_PERIOD counter ticks and the wall time is interpolated on rendering */
+// #define ELOG_TIME_COUNTER_ENABLE
+/* elog_port_get_counter ticks per second, only a first guess until the second calibration record */
+#define ELOG_TIME_COUNTER_FREQ 1000000000
+/* counter ticks between two calibration records */
+#define ELOG_TIME_CALIB_PERIOD 1000000000
 /* output newline sign */
 #define ELOG_NEWLINE_SIGN "\n"
+/* buffer size for every line's log */
+#define ELOG_LINE_BUF_SIZE 1024
+/* format the task context logs outside the output lock, into a line buffer in thread local storage (needs
+ * _Thread_local support) or on the caller's stack (every task that logs needs ELOG_LINE_BUF_SIZE more stack).
+ * Without either they are formatted under the output lock into one static line buffer. */
+// #define ELOG_LINE_BUF_THREAD_LOCAL
+// #define ELOG_LINE_BUF_ON_STACK
+/* format the log messages with the built-in formatter instead of the libc vsnprintf */
+// #define ELOG_PRINTF_ENABLE
+/* %f support of the built-in formatter */
+// #define ELOG_PRINTF_FLOAT_ENABLE
+/* formats with other conversions (%e %g %a) go to the libc vsnprintf, otherwise they are printed as they are */
+// #define ELOG_PRINTF_LIBC_FALLBACK
 /* enable asynchronous output mode */
 #define ELOG_ASYNC_OUTPUT_ENABLE
 /* buffer size for asynchronous output mode */
 #define ELOG_ASYNC_OUTPUT_BUF_SIZE 200
+/* ISR lane size, interrupt logs go there without taking the output lock (0: they share the other lanes) */
+#define ELOG_ASYNC_ISR_BUF_SIZE 0
+/* buffer size for every ISR lane log, it is on the interrupt stack */
+#define ELOG_ASYNC_ISR_LINE_BUF_SIZE 128
+/* interrupts that may log on the ISR lane at the same time, nested or on other cores, more are dropped */
+#define ELOG_ASYNC_ISR_NEST_MAX 4
+/* high severity lane size, logs at ELOG_ASYNC_HIGH_LVL or more severe go there (0: they share the output lane) */
+#define ELOG_ASYNC_HIGH_BUF_SIZE 0
+#define ELOG_ASYNC_HIGH_LVL ELOG_LVL_ERROR
+/* full ring buffer policy: ELOG_ASYNC_OVERFLOW_DROP_NEWEST, _OVERWRITE_OLDEST or _BLOCK (tasks only) */
+#define ELOG_ASYNC_OVERFLOW_POLICY ELOG_ASYNC_OVERFLOW_DROP_NEWEST
+/* longest wait for room with ELOG_ASYNC_OVERFLOW_BLOCK, in elog_port_get_time units */
+#define ELOG_ASYNC_BLOCK_TIMEOUT 10
+/* ring buffer space kept for logs at ELOG_ASYNC_RESERVE_LVL or more severe */
+#define ELOG_ASYNC_RESERVE_SIZE 0
+#define ELOG_ASYNC_RESERVE_LVL ELOG_LVL_ERROR
+/* number of logs handed to elog_port_output_batch at once by elog_async_output_batch */
+#define ELOG_ASYNC_OUTPUT_BATCH_NUM 16
+/* format straight into the asynchronous ring buffer under the output lock, saves a copy per log */
+// #define ELOG_ASYNC_ZERO_COPY_ENABLE
+/* store the ring buffer record headers compact: varint deltas to the previous record and a keyframe every
+ * ELOG_ASYNC_KEYFRAME_PERIOD records, the drain copies the records out with whole headers */
+// #define ELOG_ASYNC_COMPACT_HEADER_ENABLE
+#define ELOG_ASYNC_KEYFRAME_PERIOD 16
+/* render and compress the logs of elog_async_output_batch, the LZ4 frames go to elog_port_output_frame */
+// #define ELOG_ASYNC_COMPRESS_ENABLE
+/* text per frame (at most 65535) and log2 of the compressor hash table entries, 2 bytes each */
+#define ELOG_ASYNC_COMPRESS_BLOCK_SIZE 1024
+#define ELOG_ASYNC_COMPRESS_HASH_BITS 9
+/* keep the lanes in the region of elog_port_persist_region (noinit RAM, a mapped file), elog_init recovers
+ * the logs the previous boot left there, the output lane takes the region left by the other lanes */
+// #define ELOG_ASYNC_PERSIST_ENABLE
+/* defer formatting to the drain side, the format must stay valid (string literal) until it is drained */
+// #define ELOG_DEFERRED_FMT_ENABLE
+/* elog_hexdump copies the raw bytes into records, the hex and ASCII lines are rendered on the drain */
+// #define ELOG_HEXDUMP_ENABLE
+/* bytes per hexdump line */
+#define ELOG_HEXDUMP_WIDTH 16
+/* elog_kv packs typed key/value fields into records, they are rendered to text or JSON on the drain */
+// #define ELOG_KV_ENABLE
+/* count records, drops, ring buffer high-watermarks and latency histograms, see elog_get_stats */
+// #define ELOG_STATS_ENABLE
+/* period of the statistics log emitted by elog_async_output_batch, in elog_port_get_time units (0: never) */
+#define ELOG_STATS_OUTPUT_PERIOD 0
 
 #endif /* _ELOG_CFG_H_ */
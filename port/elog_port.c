@@ -44,8 +44,6 @@ static SemaphoreHandle_t g_log_output_lock = NULL;
 static StaticSemaphore_t g_log_output_lock_buf;
 static char              g_formatted_log[FORMATTED_LOG_LINE_MAX_LEN]; // For UART output
 
-static size_t format_log (const char *log_input, char *output, size_t size);
-
 /**
  * EasyLogger port initialize
  *
@@ -79,7 +77,65 @@ void elog_port_deinit (void)
 void elog_port_output (const char *log, size_t size)
 {
 
-    /* add your code here */
+    /* add your code here, e.g. send the line of elog_render(log, size, g_formatted_log, sizeof(g_formatted_log)) */
+}
+
+/**
+ * output a batch of logs port interface, e.g. with one DMA transfer
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+void elog_port_output_batch (const elog_span_t *logs, size_t count)
+{
+    /* add your code here, the logs are output one by one by default */
+    for (size_t i = 0; i < count; i++)
+    {
+        elog_port_output(logs[i].data, logs[i].size);
+    }
+}
+
+/**
+ * output a compressed frame of the drain port interface (ELOG_ASYNC_COMPRESS_ENABLE)
+ *
+ * @param frame frame, decode with elog_lz_frame_decode
+ * @param size frame size
+ */
+void elog_port_output_frame (const char *frame, size_t size)
+{
+    /* add your code here, e.g. send the frame over the UART */
+}
+
+/**
+ * get the region the ring buffer is kept in port interface (ELOG_ASYNC_PERSIST_ENABLE)
+ * Its content must survive a reset, and it must be aligned to ELOG_CACHE_LINE_SIZE.
+ *
+ * @param size region size
+ *
+ * @return region, NULL when there is none
+ */
+char *elog_port_persist_region (size_t *size)
+{
+    /* add your code here, e.g. return an array in a section the startup code doesn't clear:
+     * static char region[8192] __attribute__((section(".noinit"), aligned(64))); */
+}
+
+/**
+ * wait for the drain task to make room in the full ring buffer (ELOG_ASYNC_OVERFLOW_BLOCK)
+ */
+void elog_port_output_wait (void)
+{
+    /* add your code here, e.g. vTaskDelay(1) */
+}
+
+/**
+ * get the time for the latency histograms of ELOG_STATS_ENABLE, a fine clock that may wrap around
+ *
+ * @return current time
+ */
+uint32_t elog_port_stats_time (void)
+{
+    /* add your code here, e.g. DWT->CYCCNT */
 }
 
 /**
@@ -124,3 +180,15 @@ const elog_timestamp_t elog_port_get_time (void)
 {
     /* add your code here */
 }
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/**
+ * get the cycle counter interface (ELOG_TIME_COUNTER_ENABLE), e.g. DWT->CYCCNT extended to 64 bits
+ *
+ * @return counter value, it must not go back until the next boot
+ */
+elog_timestamp_t elog_port_get_counter (void)
+{
+    /* add your code here */
+}
+#endif /* ELOG_TIME_COUNTER_ENABLE */
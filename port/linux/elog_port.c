@@ -0,0 +1,496 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: Portable interface for POSIX/Linux, logs are written to a file descriptor.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * Every log is written as the prefix from elog_render_prefix followed by the message in place.
+ * The output lock is a pthread mutex. With ELOG_ASYNC_OUTPUT_ENABLE a drain thread started by
+ * elog_port_init empties the ring buffer, every batch of logs goes out with one writev. It sleeps
+ * up to ELOG_PORT_DRAIN_PERIOD while the ring buffer stays empty, a task waiting for room
+ * (ELOG_ASYNC_OVERFLOW_BLOCK) wakes it up. Signal handlers are the interrupt context of this port.
+ * With ELOG_ASYNC_PERSIST_ENABLE the ring buffer is kept in the shared mapping of ELOG_PORT_PERSIST_FILE,
+ * so the logs survive a crash of the process (not of the system) and are drained by the next run.
+ * With ELOG_FILE_ENABLE the logs go to the file sink plugin (lib/plugins/file) instead of the descriptor,
+ * the drain thread commits them while the ring buffer stays empty.
+ */
+
+#include <elog.h>
+#include <elog_port_linux.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(ELOG_FILE_ENABLE)
+    #include <elog_file.h>
+#endif /* ELOG_FILE_ENABLE */
+#if defined(ELOG_TIME_COUNTER_ENABLE) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+#endif
+
+#ifndef ELOG_PORT_OUTPUT_FD
+    #define ELOG_PORT_OUTPUT_FD STDERR_FILENO
+#endif /* ELOG_PORT_OUTPUT_FD */
+
+#ifndef ELOG_PORT_DRAIN_PERIOD
+    #define ELOG_PORT_DRAIN_PERIOD 20
+#endif /* ELOG_PORT_DRAIN_PERIOD */
+
+#ifndef ELOG_PORT_PERSIST_FILE
+    #define ELOG_PORT_PERSIST_FILE "elog.ring"
+#endif /* ELOG_PORT_PERSIST_FILE */
+
+#ifndef ELOG_PORT_PERSIST_SIZE
+    #define ELOG_PORT_PERSIST_SIZE (1024 * 1024)
+#endif /* ELOG_PORT_PERSIST_SIZE */
+
+/* logs per writev, every log takes a prefix and a message vector */
+#define WRITEV_LOG_NUM 64
+/* longest log prefix, see elog_render_prefix */
+#define PREFIX_MAX_LEN 128
+
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int      output_fd   = ELOG_PORT_OUTPUT_FD;
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+static pthread_t       drain_thread;
+static pthread_mutex_t drain_lock    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  drain_cond    = PTHREAD_COND_INITIALIZER;
+static atomic_bool     drain_running = false;
+#endif /* ELOG_ASYNC_OUTPUT_ENABLE */
+
+/**
+ * date and time text port interface, called by elog_render once per second
+ *
+ * @param sec seconds since the epoch
+ * @param text text buffer
+ * @param size text buffer size
+ *
+ * @return text length
+ */
+size_t elog_port_fmt_time (uint64_t sec, char *text, size_t size)
+{
+    time_t    time = (time_t)sec;
+    struct tm tm;
+
+    localtime_r(&time, &tm);
+    return strftime(text, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+#if !defined(ELOG_FILE_ENABLE) || defined(ELOG_ASYNC_COMPRESS_ENABLE)
+/**
+ * write all vectors to the output file descriptor, short writes and interrupted calls are resumed
+ * A non-blocking descriptor is polled until it takes more, the logs are lost on any other error.
+ *
+ * @param iov vectors, they are changed
+ * @param count number of vectors
+ */
+static void write_all (struct iovec *iov, int count)
+{
+    int fd = atomic_load_explicit(&output_fd, memory_order_relaxed);
+
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+                poll(&pfd, 1, ELOG_PORT_DRAIN_PERIOD);
+                continue;
+            }
+            return;
+        }
+
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+#endif /* !ELOG_FILE_ENABLE || ELOG_ASYNC_COMPRESS_ENABLE */
+
+#if !defined(ELOG_FILE_ENABLE)
+/**
+ * write logs with as few writev calls as possible
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+static void write_logs (const elog_span_t *logs, size_t count)
+{
+    struct iovec iov[WRITEV_LOG_NUM * 2];
+    char         prefix[WRITEV_LOG_NUM][PREFIX_MAX_LEN];
+
+    while (count > 0)
+    {
+        size_t num = (count < WRITEV_LOG_NUM) ? count : WRITEV_LOG_NUM;
+
+        for (size_t i = 0; i < num; i++)
+        {
+            elog_header_t header;
+            memcpy(&header, logs[i].data, sizeof(elog_header_t));
+
+            iov[i * 2].iov_base     = prefix[i];
+            iov[i * 2].iov_len      = elog_render_prefix(&header, prefix[i], PREFIX_MAX_LEN);
+            iov[i * 2 + 1].iov_base = (char *)logs[i].data + sizeof(elog_header_t);
+            iov[i * 2 + 1].iov_len  = header.message_length;
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+            /* a calibration record moves the time of the logs behind it and isn't written */
+            if (header.type == ELOG_RECORD_CALIB)
+            {
+                elog_render_calibrate(logs[i].data);
+                iov[i * 2].iov_len     = 0;
+                iov[i * 2 + 1].iov_len = 0;
+            }
+#endif /* ELOG_TIME_COUNTER_ENABLE */
+        }
+        write_all(iov, (int)num * 2);
+
+        logs += num;
+        count -= num;
+    }
+}
+#endif /* !ELOG_FILE_ENABLE */
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+/**
+ * drain thread, the only consumer of the asynchronous output ring buffer
+ * The sleep doubles from 1 ms up to ELOG_PORT_DRAIN_PERIOD while the ring buffer stays empty.
+ */
+static void *drain_entry (void *arg)
+{
+    long period = 1;
+
+    (void)arg;
+    while (atomic_load_explicit(&drain_running, memory_order_acquire))
+    {
+        if (elog_async_output_batch(SIZE_MAX) != 0)
+        {
+            period = 1;
+            continue;
+        }
+#if defined(ELOG_FILE_ENABLE)
+        elog_file_poll();
+#endif
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += period * 1000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec += deadline.tv_nsec / 1000000000;
+            deadline.tv_nsec %= 1000000000;
+        }
+        pthread_mutex_lock(&drain_lock);
+        if (atomic_load_explicit(&drain_running, memory_order_acquire))
+        {
+            pthread_cond_timedwait(&drain_cond, &drain_lock, &deadline);
+        }
+        pthread_mutex_unlock(&drain_lock);
+
+        if (period < ELOG_PORT_DRAIN_PERIOD)
+        {
+            period = (period * 2 < ELOG_PORT_DRAIN_PERIOD) ? period * 2 : ELOG_PORT_DRAIN_PERIOD;
+        }
+    }
+    /* the logs of elog_stop and the ones before it */
+    elog_async_output_batch(SIZE_MAX);
+
+    return NULL;
+}
+
+/**
+ * wake the drain thread up
+ */
+static void drain_wake (void)
+{
+    pthread_mutex_lock(&drain_lock);
+    pthread_cond_signal(&drain_cond);
+    pthread_mutex_unlock(&drain_lock);
+}
+#endif /* ELOG_ASYNC_OUTPUT_ENABLE */
+
+/**
+ * EasyLogger port initialize
+ *
+ * @return result
+ */
+ElogErrCode elog_port_init (void)
+{
+    ElogErrCode result = ELOG_NO_ERR;
+
+#if defined(ELOG_FILE_ENABLE)
+    result = elog_file_init();
+    if (result != ELOG_NO_ERR)
+    {
+        return result;
+    }
+#endif
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    atomic_store_explicit(&drain_running, true, memory_order_release);
+    if (pthread_create(&drain_thread, NULL, drain_entry, NULL) != 0)
+    {
+        atomic_store_explicit(&drain_running, false, memory_order_release);
+        result = ELOG_INIT_FAIL;
+    }
+#endif
+
+    return result;
+}
+
+/**
+ * EasyLogger port deinitialize, the drain thread outputs the logs left before it exits
+ *
+ */
+void elog_port_deinit (void)
+{
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    if (atomic_exchange_explicit(&drain_running, false, memory_order_acq_rel))
+    {
+        drain_wake();
+        pthread_join(drain_thread, NULL);
+    }
+#endif
+#if defined(ELOG_FILE_ENABLE)
+    elog_file_deinit();
+#endif
+}
+
+#if defined(ELOG_ASYNC_PERSIST_ENABLE)
+/**
+ * map the region the ring buffer is kept in (ELOG_ASYNC_PERSIST_ENABLE), it stays mapped until the process exits
+ * Only one process may use the file at a time.
+ *
+ * @param size region size
+ *
+ * @return region, NULL when the file can't be mapped
+ */
+char *elog_port_persist_region (size_t *size)
+{
+    int   fd = open(ELOG_PORT_PERSIST_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    void *region;
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, ELOG_PORT_PERSIST_SIZE) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    region = mmap(NULL, ELOG_PORT_PERSIST_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    *size = ELOG_PORT_PERSIST_SIZE;
+    return region;
+}
+#endif /* ELOG_ASYNC_PERSIST_ENABLE */
+
+/**
+ * set the file descriptor the logs are written to
+ *
+ * @param fd file descriptor, it stays open until the logs go elsewhere
+ */
+void elog_port_set_fd (int fd)
+{
+    atomic_store_explicit(&output_fd, fd, memory_order_relaxed);
+}
+
+/**
+ * output log port interface
+ *
+ * @param log output of log
+ * @param size log size
+ */
+void elog_port_output (const char *log, size_t size)
+{
+#if defined(ELOG_FILE_ENABLE)
+    elog_file_write(log, size);
+#else
+    elog_span_t span = {log, size};
+
+    write_logs(&span, 1);
+#endif
+}
+
+/**
+ * output a batch of logs port interface, up to WRITEV_LOG_NUM logs go out with one writev
+ *
+ * @param logs logs, header and message each
+ * @param count number of logs
+ */
+void elog_port_output_batch (const elog_span_t *logs, size_t count)
+{
+#if defined(ELOG_FILE_ENABLE)
+    elog_file_write_batch(logs, count);
+#else
+    write_logs(logs, count);
+#endif
+}
+
+#if defined(ELOG_ASYNC_COMPRESS_ENABLE)
+/**
+ * output a compressed frame of the drain (ELOG_ASYNC_COMPRESS_ENABLE), decode with elog_lz_frame_decode
+ *
+ * @param frame frame
+ * @param size frame size
+ */
+void elog_port_output_frame (const char *frame, size_t size)
+{
+    struct iovec iov = {.iov_base = (void *)frame, .iov_len = size};
+
+    write_all(&iov, 1);
+}
+#endif /* ELOG_ASYNC_COMPRESS_ENABLE */
+
+/**
+ * wait for the drain thread to make room in the full ring buffer (ELOG_ASYNC_OVERFLOW_BLOCK)
+ */
+void elog_port_output_wait (void)
+{
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    drain_wake();
+#endif
+    sched_yield();
+}
+
+/**
+ * get the time for the latency histograms of ELOG_STATS_ENABLE
+ *
+ * @return monotonic time in ns, it wraps around
+ */
+uint32_t elog_port_stats_time (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+
+/**
+ * output lock in interrupt context, a signal handler must not block on the lock it may have interrupted
+ */
+bool elog_port_output_lock_isr (void)
+{
+    return pthread_mutex_trylock(&output_lock) == 0;
+}
+
+/**
+ * output unlock in interrupt context
+ */
+bool elog_port_output_unlock_isr (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+/**
+ * output lock
+ */
+bool elog_port_output_lock (void)
+{
+    return pthread_mutex_lock(&output_lock) == 0;
+}
+
+/**
+ * output unlock
+ */
+bool elog_port_output_unlock (void)
+{
+    return pthread_mutex_unlock(&output_lock) == 0;
+}
+
+/**
+ * get current time interface
+ *
+ * @return wall clock time in ms since the epoch
+ */
+elog_timestamp_t elog_port_get_time (void)
+{
+    struct timespec  now;
+    elog_timestamp_t timestamp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms    = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    timestamp.low  = (uint32_t)ms;
+    timestamp.high = (uint32_t)(ms >> 32);
+    return timestamp;
+}
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+/**
+ * get the cycle counter interface (ELOG_TIME_COUNTER_ENABLE)
+ * It is the TSC on x86 and the virtual counter on AArch64, other targets use the raw monotonic clock in ns.
+ *
+ * @return counter value
+ */
+elog_timestamp_t elog_port_get_counter (void)
+{
+    elog_timestamp_t timestamp;
+    uint64_t         counter;
+
+#if defined(__x86_64__) || defined(__i386__)
+    counter = __rdtsc();
+#elif defined(__aarch64__)
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(counter));
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    counter = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+    timestamp.low  = (uint32_t)counter;
+    timestamp.high = (uint32_t)(counter >> 32);
+    return timestamp;
+}
+#endif /* ELOG_TIME_COUNTER_ENABLE */
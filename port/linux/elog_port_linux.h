@@ -0,0 +1,12 @@
+#ifndef _ELOG_PORT_LINUX_H
+#define _ELOG_PORT_LINUX_H
+
+/*
+ * Interfaces of the POSIX/Linux port that the library doesn't call. Build with this directory on the
+ * include path, so its elog_cfg.h is used instead of port/elog_cfg.h.
+ */
+
+// Write the logs to another file descriptor, e.g. an opened log file
+void elog_port_set_fd(int fd);
+
+#endif // _ELOG_PORT_LINUX_H
@@ -0,0 +1,662 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Copyright (c) 2015-2019, Armink, <armink.ztl@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Function: elogcat, merges binary log records of many inputs by time and filters them.
+ * Created on: 2026-10-17
+ */
+
+/*
+ * Every input is a binary segment of the file sink (elog_seg.h) or a raw dump of drained records, header
+ * and message each, as a file or a pipe. Files are mapped and read in place, the pages behind the
+ * readers are dropped every DROP_PERIOD bytes, pipes are read through a buffer of one record. The
+ * inputs are merged by timestamp and seq with a binary heap of their next records, so the memory
+ * stays the same for any input size. The seqs of every record read are checked, also of the ones the
+ * filters leave out, a hole is reported in the output where it was found. A gap marker has a seq of its
+ * own, the holes in front of it hold the logs it counts. The record header layout must be the one of the
+ * writer: build elogcat with its elog_cfg.h (make CFG=<directory>). With ELOG_TIME_COUNTER_ENABLE the cycle counter timestamps
+ * are turned into wall time with the calibration records of their input before they are merged.
+ *
+ * Usage: elogcat [options] [input...], no input or "-" reads the standard input
+ *   -l level   show this level and the more severe ones, A E W I D V or 0 to 5
+ *   -t tag     show this tag, up to TAG_MAX_NUM times, segments only (raw dumps have no site table)
+ *   -b time    show records at or after the time
+ *   -e time    show records at or before the time
+ *              time: timestamp ticks, or "YYYY-MM-DD HH:MM:SS" in local time
+ *   -f freq    timestamp ticks per second (ELOG_FMT_TIME_FREQ), 0: print the ticks
+ *   -n         prefix every line with the input name
+ *   -s         print the records and holes of every input to the standard error at the end
+ */
+
+#include <elog.h>
+#include <elog_seg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* longest message of a raw dump, a longer one means the dump is broken */
+#define MESSAGE_MAX_LEN (64 * 1024)
+/* mapped bytes read before the pages behind the reader are dropped */
+#define DROP_PERIOD     (64 * 1024 * 1024)
+#define TAG_MAX_NUM     16
+#define OUTPUT_BUF_SIZE (1024 * 1024)
+/* longest input name in the output */
+#define PATH_MAX_LEN    4096
+
+typedef struct
+{
+    const char     *name;
+    /* mapped file, a segment or a raw dump */
+    const char     *data;
+    size_t          size;
+    size_t          dropped; /* pages before it were dropped */
+    bool            is_seg;
+    elog_seg_t      seg;
+    elog_seg_iter_t iter;
+    size_t          offset;  /* next record of a raw dump */
+    /* pipe */
+    FILE           *stream;
+    char           *buf;
+    /* current record */
+    elog_header_t   header;
+    const char     *message;
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+    elog_calib_t    calib;
+#endif
+    /* seq check */
+    bool            has_seq;
+    uint32_t        last_seq;
+    uint64_t        records;
+    uint64_t        lost;
+} input_t;
+
+typedef struct
+{
+    uint32_t    levels;
+    uint64_t    time_begin;
+    uint64_t    time_end;
+    const char *tags[TAG_MAX_NUM];
+    size_t      tag_num;
+    uint32_t    freq;
+    bool        names;
+    bool        stats;
+} options_t;
+
+static const char level_letters[ELOG_LVL_TOTAL_NUM] = {'A', 'E', 'W', 'I', 'D', 'V'};
+
+static options_t options = {
+    .levels   = ELOG_SEG_LVL_ALL,
+    .time_end = UINT64_MAX,
+    .freq     = 1000,
+};
+
+static uint64_t ts_ticks (elog_timestamp_t timestamp)
+{
+    return (uint64_t)timestamp.high << 32 | timestamp.low;
+}
+
+/**
+ * open an input, a regular file is mapped
+ *
+ * @return false when it can't be read
+ */
+static bool input_open (input_t *input, const char *name)
+{
+    struct stat st;
+    int         fd;
+
+    memset(input, 0, sizeof(input_t));
+    input->name = name;
+    if (strcmp(name, "-") == 0)
+    {
+        input->name = "<stdin>";
+        fd          = dup(STDIN_FILENO);
+    }
+    else
+    {
+        fd = open(name, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "elogcat: %s: %s\n", input->name, strerror(errno));
+        return false;
+    }
+
+    if (!S_ISREG(st.st_mode))
+    {
+        input->stream = fdopen(fd, "rb");
+        input->buf    = malloc(sizeof(elog_header_t) + MESSAGE_MAX_LEN);
+        return input->stream != NULL && input->buf != NULL;
+    }
+
+    input->size = (size_t)st.st_size;
+    if (input->size != 0)
+    {
+        input->data = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (input->data == MAP_FAILED)
+        {
+            fprintf(stderr, "elogcat: %s: %s\n", input->name, strerror(errno));
+            close(fd);
+            return false;
+        }
+        madvise((void *)input->data, input->size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    uint32_t magic = 0;
+    if (input->size >= sizeof(magic))
+    {
+        memcpy(&magic, input->data, sizeof(magic));
+    }
+    if (magic == ELOG_SEG_MAGIC)
+    {
+        if (elog_seg_open(&input->seg, input->data, input->size) != ELOG_NO_ERR)
+        {
+            fprintf(stderr, "elogcat: %s: segment of another record header, see CFG in the Makefile\n", input->name);
+            return false;
+        }
+        /* the levels and the times are filtered after the seq check, the range only picks the blocks */
+        elog_seg_filter_t filter = {options.time_begin, options.time_end, ELOG_SEG_LVL_ALL, true};
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+        /* the index has counters, the calibration records in front of the range are needed too */
+        filter.time_begin = 0;
+        filter.time_end   = UINT64_MAX;
+#endif
+        input->is_seg            = true;
+        elog_seg_iter_init(&input->iter, &input->seg, &filter);
+    }
+
+    return true;
+}
+
+static void input_close (input_t *input)
+{
+    if (input->data != NULL && input->data != MAP_FAILED)
+    {
+        munmap((void *)input->data, input->size);
+    }
+    if (input->stream != NULL)
+    {
+        fclose(input->stream);
+    }
+    free(input->buf);
+}
+
+/* drop the mapped pages behind the reader, so a big input doesn't fill the memory */
+static void input_drop (input_t *input, size_t offset)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    if (offset - input->dropped >= DROP_PERIOD)
+    {
+        size_t end = offset / page * page;
+
+        madvise((void *)(input->data + input->dropped), end - input->dropped, MADV_DONTNEED);
+        input->dropped = end;
+    }
+}
+
+/**
+ * read the next record of a raw dump
+ *
+ * @return false at the end, a broken record ends the input
+ */
+static bool input_read_raw (input_t *input)
+{
+    if (input->stream != NULL)
+    {
+        if (fread(input->buf, sizeof(elog_header_t), 1, input->stream) != 1)
+        {
+            return false;
+        }
+        memcpy(&input->header, input->buf, sizeof(elog_header_t));
+        if (input->header.message_length > MESSAGE_MAX_LEN)
+        {
+            fprintf(stderr, "elogcat: %s: broken record after seq %u\n", input->name, input->last_seq);
+            return false;
+        }
+        if (fread(input->buf + sizeof(elog_header_t), 1, input->header.message_length, input->stream)
+            != input->header.message_length)
+        {
+            return false;
+        }
+        input->message = input->buf + sizeof(elog_header_t);
+        return true;
+    }
+
+    if (input->size - input->offset < sizeof(elog_header_t))
+    {
+        return false;
+    }
+    memcpy(&input->header, input->data + input->offset, sizeof(elog_header_t));
+    if (input->header.message_length > MESSAGE_MAX_LEN
+        || input->header.message_length > input->size - input->offset - sizeof(elog_header_t))
+    {
+        if (input->header.message_length > MESSAGE_MAX_LEN)
+        {
+            fprintf(stderr, "elogcat: %s: broken record after seq %u\n", input->name, input->last_seq);
+        }
+        return false;
+    }
+    input->message = input->data + input->offset + sizeof(elog_header_t);
+    input->offset += sizeof(elog_header_t) + input->header.message_length;
+    input_drop(input, input->offset);
+
+    return true;
+}
+
+/* write a hole in the seqs of an input */
+static void print_hole (const input_t *input, uint32_t lost)
+{
+    printf("--- %s: %u records lost before seq %u ---\n", input->name, lost, input->header.seq_num);
+}
+
+/* check the seq of the current record against the last one of its input */
+static void check_seq (input_t *input)
+{
+    uint32_t seq = input->header.seq_num;
+
+    if (input->has_seq && seq != input->last_seq + 1)
+    {
+        /* a seq going back is a new boot, not a hole */
+        if ((int32_t)(seq - input->last_seq) > 1)
+        {
+            input->lost += seq - input->last_seq - 1;
+            print_hole(input, seq - input->last_seq - 1);
+        }
+    }
+    input->has_seq  = true;
+    input->last_seq = seq;
+}
+
+/**
+ * read the next record of an input in the time range
+ *
+ * @return false at the end of the input
+ */
+static bool input_next (input_t *input)
+{
+    for (;;)
+    {
+        if (input->is_seg)
+        {
+            elog_span_t record;
+
+            if (!elog_seg_next(&input->iter, &record))
+            {
+                return false;
+            }
+            memcpy(&input->header, record.data, sizeof(elog_header_t));
+            input->message = record.data + sizeof(elog_header_t);
+            input_drop(input, input->iter.offset);
+        }
+        else if (!input_read_raw(input))
+        {
+            return false;
+        }
+        /* every record read has a seq, the ones that aren't shown too */
+        check_seq(input);
+
+#if defined(ELOG_TIME_COUNTER_ENABLE)
+        if (input->header.type == ELOG_RECORD_CALIB)
+        {
+            elog_calib_update(&input->calib, input->message - sizeof(elog_header_t));
+            continue;
+        }
+        input->header.timestamp = elog_calib_time(&input->calib, input->header.timestamp);
+#endif
+
+        uint64_t time = ts_ticks(input->header.timestamp);
+        if (time >= options.time_begin && time <= options.time_end)
+        {
+            return true;
+        }
+    }
+}
+
+/* the record of input a goes before the one of input b */
+static bool record_before (const input_t *a, const input_t *b)
+{
+    uint64_t time_a = ts_ticks(a->header.timestamp);
+    uint64_t time_b = ts_ticks(b->header.timestamp);
+
+    if (time_a != time_b)
+    {
+        return time_a < time_b;
+    }
+    if (a->header.seq_num != b->header.seq_num)
+    {
+        return (int32_t)(a->header.seq_num - b->header.seq_num) < 0;
+    }
+    return a < b;
+}
+
+/* move the top of the heap down to its place */
+static void heap_down (input_t **heap, size_t num, size_t i)
+{
+    input_t *top = heap[i];
+
+    for (;;)
+    {
+        size_t child = i * 2 + 1;
+
+        if (child >= num)
+        {
+            break;
+        }
+        if (child + 1 < num && record_before(heap[child + 1], heap[child]))
+        {
+            child++;
+        }
+        if (!record_before(heap[child], top))
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i       = child;
+    }
+    heap[i] = top;
+}
+
+/* append decimal text of an integer */
+static char *put_u64 (char *p, uint64_t value)
+{
+    char  digits[20];
+    char *d = digits + sizeof(digits);
+
+    do
+    {
+        *--d = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    memcpy(p, d, (size_t)(digits + sizeof(digits) - d));
+
+    return p + (digits + sizeof(digits) - d);
+}
+
+static char *put_text (char *p, const char *text)
+{
+    size_t len = strlen(text);
+
+    memcpy(p, text, len);
+    return p + len;
+}
+
+/* write a record as a line, a message without a newline gets one */
+static void print_record (const input_t *input)
+{
+    static uint64_t cached_sec = UINT64_MAX;
+    static char     time_text[32];
+    /* prefix: name, time, seq, level and tag */
+    static char     prefix[PATH_MAX_LEN + 64 + 4096];
+    char           *p     = prefix;
+    uint64_t        ticks = ts_ticks(input->header.timestamp);
+    uint8_t         level = input->header.level;
+    elog_seg_site_t site;
+
+    if (options.names)
+    {
+        size_t len = strnlen(input->name, PATH_MAX_LEN);
+
+        memcpy(p, input->name, len);
+        p += len;
+        *p++ = ':';
+        *p++ = ' ';
+    }
+    if (options.freq == 0)
+    {
+        p = put_u64(p, ticks);
+    }
+    else
+    {
+        uint64_t sec = ticks / options.freq;
+        uint32_t ms  = (uint32_t)((ticks - sec * options.freq) * 1000 / options.freq);
+
+        if (sec != cached_sec)
+        {
+            time_t    time = (time_t)sec;
+            struct tm tm;
+
+            localtime_r(&time, &tm);
+            strftime(time_text, sizeof(time_text), "%Y-%m-%d %H:%M:%S", &tm);
+            cached_sec = sec;
+        }
+        p    = put_text(p, time_text);
+        *p++ = '.';
+        *p++ = (char)('0' + ms / 100);
+        *p++ = (char)('0' + ms / 10 % 10);
+        *p++ = (char)('0' + ms % 10);
+    }
+    *p++ = ' ';
+    *p++ = '#';
+    p    = put_u64(p, input->header.seq_num);
+    *p++ = ' ';
+    *p++ = '[';
+    *p++ = (level < ELOG_LVL_TOTAL_NUM) ? level_letters[level] : '?';
+    *p++ = ']';
+    *p++ = ' ';
+    if (input->is_seg && elog_seg_find_site(&input->seg, input->header.site_id, &site))
+    {
+        size_t len = strnlen(site.tag, 4096 - 2);
+
+        memcpy(p, site.tag, len);
+        p += len;
+        *p++ = ':';
+        *p++ = ' ';
+    }
+
+    fwrite_unlocked(prefix, 1, (size_t)(p - prefix), stdout);
+    fwrite_unlocked(input->message, 1, input->header.message_length, stdout);
+    if (input->header.message_length == 0 || input->message[input->header.message_length - 1] != '\n')
+    {
+        putchar_unlocked('\n');
+    }
+}
+
+/* the record passes the level and tag filter */
+static bool record_shown (const input_t *input)
+{
+    elog_seg_site_t site;
+
+    if (input->header.level >= ELOG_LVL_TOTAL_NUM || !(options.levels & ELOG_SEG_LVL(input->header.level)))
+    {
+        return false;
+    }
+    if (options.tag_num == 0)
+    {
+        return true;
+    }
+    if (!input->is_seg || !elog_seg_find_site(&input->seg, input->header.site_id, &site))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < options.tag_num; i++)
+    {
+        if (strcmp(site.tag, options.tags[i]) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * parse a time option, timestamp ticks or a local date and time
+ *
+ * @return false when it isn't a time
+ */
+static bool parse_time (const char *text, uint64_t *time)
+{
+    struct tm tm;
+    char     *end;
+
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(text, "%Y-%m-%d %H:%M:%S", &tm);
+    if (end != NULL && *end == '\0')
+    {
+        tm.tm_isdst = -1;
+        *time       = (uint64_t)mktime(&tm) * (options.freq ? options.freq : 1);
+        return true;
+    }
+
+    *time = strtoull(text, &end, 0);
+    return end != text && *end == '\0';
+}
+
+static bool parse_level (const char *text, uint32_t *levels)
+{
+    int level = -1;
+
+    for (int i = 0; i < ELOG_LVL_TOTAL_NUM; i++)
+    {
+        if (text[0] == level_letters[i] || text[0] == level_letters[i] + ('a' - 'A') || text[0] == '0' + i)
+        {
+            level = i;
+        }
+    }
+    if (level < 0 || text[1] != '\0')
+    {
+        return false;
+    }
+
+    *levels = ELOG_SEG_LVL(level + 1) - 1;
+    return true;
+}
+
+static int usage (void)
+{
+    fprintf(stderr, "usage: elogcat [-l level] [-t tag]... [-b time] [-e time] [-f freq] [-n] [-s] [input...]\n");
+    return 2;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *begin = NULL, *end = NULL;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "l:t:b:e:f:ns")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            if (!parse_level(optarg, &options.levels))
+            {
+                return usage();
+            }
+            break;
+        case 't':
+            if (options.tag_num == TAG_MAX_NUM)
+            {
+                return usage();
+            }
+            options.tags[options.tag_num++] = optarg;
+            break;
+        case 'b':
+            begin = optarg;
+            break;
+        case 'e':
+            end = optarg;
+            break;
+        case 'f':
+            options.freq = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            options.names = true;
+            break;
+        case 's':
+            options.stats = true;
+            break;
+        default:
+            return usage();
+        }
+    }
+    /* the dates depend on the frequency */
+    if ((begin != NULL && !parse_time(begin, &options.time_begin)) || (end != NULL && !parse_time(end, &options.time_end)))
+    {
+        return usage();
+    }
+
+    size_t      input_num = (optind < argc) ? (size_t)(argc - optind) : 1;
+    input_t    *inputs    = calloc(input_num, sizeof(input_t));
+    input_t   **heap      = calloc(input_num, sizeof(input_t *));
+    size_t      heap_num  = 0;
+    int         result    = 0;
+    static char output_buf[OUTPUT_BUF_SIZE];
+
+    setvbuf(stdout, output_buf, _IOFBF, sizeof(output_buf));
+    for (size_t i = 0; i < input_num; i++)
+    {
+        if (!input_open(&inputs[i], (optind < argc) ? argv[optind + (int)i] : "-"))
+        {
+            result = 1;
+            continue;
+        }
+        if (input_next(&inputs[i]))
+        {
+            heap[heap_num++] = &inputs[i];
+        }
+    }
+    for (size_t i = heap_num / 2; i-- > 0;)
+    {
+        heap_down(heap, heap_num, i);
+    }
+
+    while (heap_num > 0)
+    {
+        input_t *input = heap[0];
+
+        input->records++;
+        if (record_shown(input))
+        {
+            print_record(input);
+        }
+        if (!input_next(input))
+        {
+            heap[0] = heap[--heap_num];
+        }
+        heap_down(heap, heap_num, 0);
+    }
+    fflush(stdout);
+
+    for (size_t i = 0; i < input_num; i++)
+    {
+        if (options.stats && inputs[i].name != NULL)
+        {
+            fprintf(stderr, "%s: %llu records, %llu lost\n", inputs[i].name, (unsigned long long)inputs[i].records,
+                    (unsigned long long)inputs[i].lost);
+        }
+        input_close(&inputs[i]);
+    }
+    free(inputs);
+    free(heap);
+
+    return result;
+}